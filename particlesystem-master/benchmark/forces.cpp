@@ -0,0 +1,190 @@
+#include "catch2.h"
+#include "gravityWell.hpp"
+#include "wind.hpp"
+#include "forceField.hpp"
+#include "forceGrid.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr std::size_t Count = 16384;
+
+    std::vector<vec2> randomPositions(std::size_t count) {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        std::vector<vec2> positions(count);
+        for (vec2& p : positions) {
+            p = vec2(distribution(generator), distribution(generator));
+        }
+        return positions;
+    }
+
+    // The kernels add to \p forces, so every sample starts from zero instead of from the
+    // sums of all samples before it
+    template <typename Kernel>
+    void measureFromZero(Catch::Benchmark::Chronometer& meter, std::vector<vec2>& forces, Kernel kernel) {
+        std::fill(forces.begin(), forces.end(), vec2(0.0f, 0.0f));
+        meter.measure([&]() {
+            kernel();
+            return forces[0].x;
+        });
+    }
+} // namespace
+
+// Each kernel is measured three ways: one virtual computeForce call per particle (scalar),
+// the generic Force::accumulateForces loop (batch), and the type's own kernel (SIMD)
+
+TEST_CASE("Gravity well kernels", "[gravity]") {
+    const std::vector<vec2> positions = randomPositions(Count);
+    std::vector<vec2> forces(Count);
+
+    GravityWell well({0.1f, 0.2f}, 6.0f, {1, 1, 1});
+    std::vector<GravityWell*> wells = { &well };
+    GravityKernel kernel;
+    kernel.setWells(wells);
+
+    BENCHMARK_ADVANCED("scalar computeForce")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            Force& force = well;
+            for (std::size_t i = 0; i < Count; i++) {
+                forces[i] += force.computeForce(positions[i]);
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("batch Force::accumulateForces")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            well.Force::accumulateForces(positions.data(), forces.data(), Count);
+        });
+    };
+
+    BENCHMARK_ADVANCED("SIMD GravityKernel")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            kernel.accumulate(positions.data(), forces.data(), Count);
+        });
+    };
+
+    kernel.setPrecise(true);
+    BENCHMARK_ADVANCED("SIMD GravityKernel, precise")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            kernel.accumulate(positions.data(), forces.data(), Count);
+        });
+    };
+}
+
+TEST_CASE("Gravity kernel with many wells", "[gravity]") {
+    const std::vector<vec2> positions = randomPositions(Count);
+    const std::vector<vec2> wellPositions = randomPositions(16);
+    std::vector<vec2> forces(Count);
+
+    std::vector<GravityWell> wells;
+    for (vec2 p : wellPositions) {
+        wells.emplace_back(p, 6.0f, Color(1, 1, 1));
+    }
+    std::vector<GravityWell*> wellPointers;
+    for (GravityWell& w : wells) {
+        wellPointers.push_back(&w);
+    }
+    GravityKernel kernel;
+    kernel.setWells(wellPointers);
+
+    BENCHMARK_ADVANCED("scalar computeForce, 16 wells")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            for (GravityWell* w : wellPointers) {
+                for (std::size_t i = 0; i < Count; i++) {
+                    forces[i] += w->computeForce(positions[i]);
+                }
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("SIMD GravityKernel, 16 wells")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            kernel.accumulate(positions.data(), forces.data(), Count);
+        });
+    };
+}
+
+TEST_CASE("Wind kernels", "[wind]") {
+    const std::vector<vec2> positions = randomPositions(Count);
+    std::vector<vec2> forces(Count);
+    Wind wind({-0.3f, 0.4f}, 6.0f, {1, 1, 1}, 0.7f);
+
+    BENCHMARK_ADVANCED("scalar computeForce")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            Force& force = wind;
+            for (std::size_t i = 0; i < Count; i++) {
+                forces[i] += force.computeForce(positions[i]);
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("batch Force::accumulateForces")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            wind.Force::accumulateForces(positions.data(), forces.data(), Count);
+        });
+    };
+
+    BENCHMARK_ADVANCED("SIMD Wind::accumulateForces")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            wind.accumulateForces(positions.data(), forces.data(), Count);
+        });
+    };
+}
+
+TEST_CASE("Force evaluation strategies", "[forcefield][radius]") {
+    const std::vector<vec2> positions = randomPositions(Count);
+    const std::vector<vec2> sources = randomPositions(32);
+    std::vector<vec2> forces(Count);
+
+    std::vector<GravityWell> wells;
+    std::vector<Wind> winds;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        if (i % 2 == 0) {
+            wells.emplace_back(sources[i], 6.0f, Color(1, 1, 1), 0.01f, 0.25f);
+        }
+        else {
+            winds.emplace_back(sources[i], 6.0f, Color(1, 1, 1), 0.7f, 0.25f);
+        }
+    }
+    std::vector<GravityWell*> wellPointers;
+    std::vector<Wind*> windPointers;
+    std::vector<Force*> allForces;
+    for (GravityWell& w : wells) {
+        wellPointers.push_back(&w);
+        allForces.push_back(&w);
+    }
+    for (Wind& w : winds) {
+        windPointers.push_back(&w);
+        allForces.push_back(&w);
+    }
+
+    GravityKernel kernel;
+    kernel.setWells(wellPointers);
+    ForceField field;
+    field.bake(allForces);
+    ForceGrid grid;
+    grid.build(wellPointers, windPointers, false);
+
+    BENCHMARK_ADVANCED("direct, 32 local forces")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            kernel.accumulate(positions.data(), forces.data(), Count);
+            for (Wind* w : windPointers) {
+                w->accumulateForces(positions.data(), forces.data(), Count);
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("culled by ForceGrid, 32 local forces")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            grid.accumulate(positions.data(), forces.data(), Count);
+        });
+    };
+
+    BENCHMARK_ADVANCED("baked ForceField")(Catch::Benchmark::Chronometer meter) {
+        measureFromZero(meter, forces, [&]() {
+            field.accumulate(positions.data(), forces.data(), Count);
+        });
+    };
+}
@@ -0,0 +1,10 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch2.h"
+
+// Run with -c "<case>" to select a single benchmark, and with --benchmark-samples or
+// --benchmark-resamples to trade run time against the width of the confidence interval.
+// Only optimized builds give meaningful numbers.
+int main(int argc, char** argv) {
+    int result = Catch::Session().run(argc, argv);
+    return result;
+}
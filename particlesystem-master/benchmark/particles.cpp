@@ -0,0 +1,118 @@
+#include "catch2.h"
+#include "particle.h"
+#include "particlesystem.h"
+#include "uniform.hpp"
+#include "directional.hpp"
+#include "util/vec2xN.h"
+#include <vector>
+
+namespace {
+    constexpr std::size_t Count = 16384;
+} // namespace
+
+// Integration and emission are measured the same ways as the force kernels where the data
+// allows it. The particles are stored as an array of structs, so the system can only use the
+// scalar loop; the batch and SIMD variants run on separate arrays (structure of arrays) to
+// show what that layout would gain
+
+TEST_CASE("Particle integration", "[particle]") {
+    ParticleArchetypeTable archetypes;
+    const std::uint32_t archetype = archetypes.add({3.0f, {1, 1, 1}, 20.0f, 60.0f});
+    std::vector<vec2> forces(Count, vec2(0.01f, -0.02f));
+    const float dt = 0.016f;
+
+    BENCHMARK_ADVANCED("scalar updateSingleParticle")(Catch::Benchmark::Chronometer meter) {
+        std::vector<Particle> particles(Count, Particle({0.0f, 0.0f}, {0.1f, 0.2f}, archetype, 60.0f));
+        meter.measure([&]() {
+            for (std::size_t i = 0; i < Count; i++) {
+                particles[i].updateSingleParticle(dt, forces[i], archetypes[particles[i].getArchetype()].inverseMass);
+            }
+            return particles[Count / 2].position.x;
+        });
+    };
+
+    BENCHMARK_ADVANCED("batch, structure of arrays")(Catch::Benchmark::Chronometer meter) {
+        std::vector<vec2> positions(Count, vec2(0.0f, 0.0f));
+        std::vector<vec2> velocities(Count, vec2(0.1f, 0.2f));
+        std::vector<float> lifetimes(Count, 60.0f);
+        std::vector<float> inverseMasses(Count, archetypes[archetype].inverseMass);
+        meter.measure([&]() {
+            for (std::size_t i = 0; i < Count; i++) {
+                velocities[i] += forces[i] * (inverseMasses[i] * dt);
+                positions[i] += velocities[i] * dt;
+                lifetimes[i] -= dt;
+            }
+            return positions[Count / 2].x;
+        });
+    };
+
+    BENCHMARK_ADVANCED("SIMD vec2xN, structure of arrays")(Catch::Benchmark::Chronometer meter) {
+        using Batch = simd::vec2v;
+        using Floats = simd::floatv;
+        std::vector<vec2> positions(Count, vec2(0.0f, 0.0f));
+        std::vector<vec2> velocities(Count, vec2(0.1f, 0.2f));
+        std::vector<float> lifetimes(Count, 60.0f);
+        std::vector<float> inverseMasses(Count, archetypes[archetype].inverseMass);
+        meter.measure([&]() {
+            for (std::size_t i = 0; i < Count; i += Batch::Width) {
+                const Batch velocity = Batch::load(&velocities[i]) + Batch::load(&forces[i]) * (Floats::load(&inverseMasses[i]) * dt);
+                velocity.store(&velocities[i]);
+                (velocity * dt).addTo(&positions[i]);
+                (Floats::load(&lifetimes[i]) - dt).store(&lifetimes[i]);
+            }
+            return positions[Count / 2].x;
+        });
+    };
+}
+
+// Emission writes whole particles and steps a direction table, there is no SIMD variant
+
+TEST_CASE("Emitters", "[emitter]") {
+    Uniform uniform({0.0f, 0.0f}, 8.0f, {1, 1, 1});
+    Directional directional({0.0f, 0.0f}, 8.0f, {1, 1, 1}, 0.5f);
+    uniform.setSpawnRate(64);
+    directional.setSpawnRate(64);
+
+    BENCHMARK("scalar Uniform::createParticles") {
+        return uniform.createParticles(64.0f, 0.0f).size();
+    };
+
+    BENCHMARK("scalar Directional::createParticles") {
+        return directional.createParticles(64.0f, 0.5f).size();
+    };
+
+    // Into memory that is reused, like ParticleSystem does with its spawn ranges
+    std::vector<Particle> out(64, Particle({0.0f, 0.0f}, {0.0f, 0.0f}, 0, 0.0f));
+
+    BENCHMARK("batch Uniform::emit") {
+        uniform.emit(out.data(), 64.0f, 0.0f);
+        return out[0].position.x;
+    };
+
+    BENCHMARK("batch Directional::emit") {
+        directional.emit(out.data(), 64.0f, 0.5f);
+        return out[0].position.x;
+    };
+}
+
+TEST_CASE("Particle system update", "[particlesystem]") {
+    BENCHMARK_ADVANCED("update, 4 emitters and 4 forces")(Catch::Benchmark::Chronometer meter) {
+        ParticleSystem system;
+        system.addUniform({-0.5f, 0.0f});
+        system.addUniform({0.5f, 0.0f});
+        system.addDirectional({0.0f, -0.5f});
+        system.addDirectional({0.0f, 0.5f});
+        system.addGravityWell({0.0f, 0.0f});
+        system.addGravityWell({0.3f, 0.3f}, 0.5f);
+        system.addWind({-0.3f, 0.3f});
+        system.addWind({0.3f, -0.3f}, 0.5f);
+        // Fill the system to a steady state before measuring
+        for (int i = 0; i < 2000; i++) {
+            system.update(0.016f, 64.0f, 0.5f);
+        }
+        meter.measure([&]() {
+            system.update(0.016f, 64.0f, 0.5f);
+            return system.getParticles().size();
+        });
+    };
+}
@@ -0,0 +1,58 @@
+#include "catch2.h"
+#include "util/vec2.h"
+#include <vector>
+
+namespace {
+    constexpr std::size_t Count = 4096;
+
+    std::vector<vec2> makeVectors(float offset) {
+        std::vector<vec2> v(Count);
+        for (std::size_t i = 0; i < Count; i++) {
+            v[i] = vec2(offset + 0.001f * i, offset - 0.002f * i);
+        }
+        return v;
+    }
+} // namespace
+
+TEST_CASE("vec2 arithmetic", "[vec2]") {
+    const std::vector<vec2> a = makeVectors(1.0f);
+    const std::vector<vec2> b = makeVectors(-0.5f);
+    std::vector<vec2> out(Count);
+
+    // Every benchmark returns a value derived from its output so it cannot be optimized away
+    BENCHMARK("add 4096") {
+        for (std::size_t i = 0; i < Count; i++) {
+            out[i] = a[i] + b[i];
+        }
+        return out[Count / 2].x;
+    };
+
+    BENCHMARK("multiply-add 4096") {
+        for (std::size_t i = 0; i < Count; i++) {
+            out[i] = a[i] * 0.5f + b[i];
+        }
+        return out[Count / 2].x;
+    };
+
+    BENCHMARK("divide 4096") {
+        for (std::size_t i = 0; i < Count; i++) {
+            out[i] = a[i] / 3.0f;
+        }
+        return out[Count / 2].x;
+    };
+
+    BENCHMARK("length 4096") {
+        float sum = 0.0f;
+        for (std::size_t i = 0; i < Count; i++) {
+            sum += a[i].length();
+        }
+        return sum;
+    };
+
+    BENCHMARK("normalize 4096") {
+        for (std::size_t i = 0; i < Count; i++) {
+            out[i] = a[i].normalized();
+        }
+        return out[Count / 2].x;
+    };
+}
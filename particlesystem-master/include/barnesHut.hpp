@@ -0,0 +1,74 @@
+//
+//  barnesHut.hpp
+//  ParticleSystem
+//
+
+#ifndef barnesHut_hpp
+#define barnesHut_hpp
+
+#include "util/threadpool.h"
+#include "util/vec2.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A Barnes-Hut quadtree used to let particles attract each other in O(n log n). The tree
+ * is rebuilt every step: particles are sorted along a Morton (Z-order) curve and the
+ * nodes are stored depth-first in one array, each node knowing the index of the node
+ * that follows its subtree. Walking the tree is therefore a linear scan that skips
+ * subtrees, without any recursion or pointer chasing.
+ */
+class BarnesHutTree {
+public:
+    /// A node whose width divided by its distance to the particle is below the opening
+    /// angle is treated as a single mass. 0 gives the exact O(n^2) result, larger values
+    /// trade accuracy for speed. Around 0.5 is a common choice. Nodes that contain the
+    /// particle itself are always opened, so large angles never include its own mass
+    void setOpeningAngle(float theta);
+    float getOpeningAngle() const;
+
+    /// The force between two particles is G*m1*m2*dist/(|dist|^2 + softening^2)^(3/2)
+    void setGravitationalConstant(float G);
+    void setSoftening(float inSoftening);
+
+    /// Builds the tree from \p count particles with the given \p positions and \p masses
+    void build(const vec2* positions, const float* masses, std::size_t count);
+
+    /**
+     * Adds the gravitational force from all other particles to \p forces. The particles
+     * are processed in Morton order on all threads of \p pool
+     *
+     * \pre build has been called with the same particles
+     */
+    void accumulate(vec2* forces, ThreadPool& pool) const;
+
+    std::size_t getNumberOfNodes() const;
+
+private:
+    struct Node {
+        vec2 centerOfMass;
+        float mass = 0.0f;
+        float widthSquared = 0.0f;
+        std::uint32_t next = 0;         //Index för noden efter detta delträd
+        std::uint32_t firstParticle = 0;
+        std::uint32_t numberOfParticles = 0;
+        bool leaf = false;
+    };
+
+    std::uint32_t buildNode(std::uint32_t begin, std::uint32_t end, int level, float width);
+    vec2 computeForce(std::uint32_t particle) const;
+
+    float openingAngleSquared = 0.25f;
+    float gravitationalConstant = 0.01f;
+    float softeningSquared = 0.0001f;
+
+    std::vector<Node> nodes;
+    std::vector<std::uint64_t> keys;       //Mortonkod i de höga 32 bitarna, index i de låga
+    std::vector<std::uint32_t> codes;
+    std::vector<std::uint32_t> order;
+    std::vector<vec2> sortedPositions;
+    std::vector<float> sortedMasses;
+};
+
+#endif /* barnesHut_hpp */
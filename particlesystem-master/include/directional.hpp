@@ -14,7 +14,8 @@
 class Directional: public Emitter{
 public:
     Directional(vec2 inPosition, float inSize, Color inColor, float inAngle): Emitter(inPosition, inSize, inColor){angle = inAngle;};
-    std::vector<Particle> createParticles(float numberOfSpawnDirections, float inAngle);
+    void emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle);
+    ParticleArchetype getParticleArchetype() const;
     
 private:
     float angle;
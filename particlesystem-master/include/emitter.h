@@ -10,28 +10,98 @@
 #define _USE_MATH_DEFINES
 
 #include "util/color.h"
+#include "util/random.h"
 #include "util/rendering.h"
 #include "util/vec2.h"
 #include "particle.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <cmath>
 
 #include <stdio.h>
 
+/// How much the particles of an emitter vary, 0 everywhere gives identical particles
+struct EmitterJitter {
+    /// The largest change of the start direction, in radians in both directions
+    float angle = 0.0f;
+    /// The largest relative change of the start speed and the lifetime, 0.2 means +-20%
+    float speed = 0.0f;
+    float lifetime = 0.0f;
+    /// The largest change of each color channel, picked from a few archetype variants
+    float color = 0.0f;
+
+    bool isActive() const { return angle != 0.0f || speed != 0.0f || lifetime != 0.0f || color != 0.0f; }
+};
+
 class Emitter {
 public:
     Emitter(vec2 inPosition, float inSize, Color inColor);
 
-    virtual std::vector<Particle> createParticles(float numberOfSpawnDirections, float inAngle) = 0;
-    rendering::EmitterInfo toEmitterInfo();
+    /// The number of particles that the next call to emitParticles writes
+    virtual std::size_t getSpawnCount() const;
+
+    /**
+     * Writes exactly getSpawnCount() new particles to \p out. Only the state of this
+     * emitter is changed, so different emitters can emit concurrently into disjoint ranges.
+     */
+    virtual void emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle) = 0;
+
+    /// Calls emitParticles and applies the jitter, this is what the particle system calls
+    void emit(Particle* out, float numberOfSpawnDirections, float inAngle);
+
+    /// Emits into a new vector, see emit
+    std::vector<Particle> createParticles(float numberOfSpawnDirections, float inAngle);
+    rendering::EmitterInfo toEmitterInfo() const;
+
+    /// Describes the particles that this emitter creates
+    virtual ParticleArchetype getParticleArchetype() const = 0;
+
+    /// Sets the index of this emitter's archetype in the owning system's archetype table
+    void setArchetype(std::uint32_t inArchetype, const ParticleArchetype& inDescription);
+    std::uint32_t getArchetype() const;
+
+    /// Sets how many particles each call to emitParticles creates, at least 1
+    void setSpawnRate(int inParticlesPerUpdate);
+    int getSpawnRate() const;
+
+    /// The length of the update that the particles are emitted during. Emitters that send
+    /// several particles the same way spread them out over it instead of stacking them
+    void setTimestep(float dt);
+
+    /**
+     * Randomizes the particles from this emitter. Particle i of the emitter always gets
+     * the i-th element of \p inStream, so the result does not depend on which thread emits.
+     *
+     * \param inColorVariants The archetypes that the particles pick from at random, empty
+     *        keeps the emitter's own archetype
+     */
+    void setJitter(const EmitterJitter& inJitter, const rng::Stream& inStream,
+                   std::vector<std::uint32_t> inColorVariants = {});
+    const EmitterJitter& getJitter() const;
+    /// The archetypes picked by the color jitter, empty without color jitter
+    const std::vector<std::uint32_t>& getColorVariants() const;
+    /// Replaces the archetypes picked by the color jitter, e.g. with private copies
+    void setColorVariants(std::vector<std::uint32_t> inColorVariants);
     
 protected:
     vec2 position;
     Color color;
+    std::uint32_t archetype = 0;
+    float particleLifetime = 60.0f;
+    int particlesPerUpdate = 1;
+    float timestep = 0.0f;
     
 private:
+    void applyJitter(Particle* out, std::size_t count);
+
     float size;
+    EmitterJitter jitter;
+    rng::Stream stream;
+    std::vector<std::uint32_t> colorVariants;
+    //Hur många partiklar som skapats, index i den slumpade strömmen
+    std::uint64_t numberOfEmitted = 0;
+    std::vector<float> randomScratch;
 };
 
 #endif /* emitter_h */
@@ -14,19 +14,41 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstddef>
 
 #include <stdio.h>
 
 class Force {
 public:
-    Force(vec2 inPosition, float inSize, Color inColor);
+    Force(vec2 inPosition, float inSize, Color inColor, float inRadius = 0.0f);
     virtual ~Force() = default;
 
     //void changeForceType(std::string type);
-    rendering::ForceInfo toForceInfo();
+    rendering::ForceInfo toForceInfo() const;
+    vec2 getPosition() const;
+
+    /// The distance beyond which the force has no effect. Inside the radius the force is
+    /// scaled by the smooth fall-off (1 - d^2/r^2)^2. A radius of 0 makes the force global
+    float getInfluenceRadius() const;
+    bool isGlobal() const;
     virtual vec2 computeForce(vec2 particlePosition) = 0;
+
+    /// Adds the force acting on each of the \p count \p positions to \p forces. The
+    /// default implementation calls computeForce for every position, subclasses override
+    /// it with vectorised kernels
+    virtual void accumulateForces(const vec2* positions, vec2* forces, std::size_t count);
 protected:
+    /// Returns the fall-off weight in [0, 1] for a particle at squared distance
+    /// \p distSquared, or 1 if the force is global
+    inline float falloff(float distSquared) const {
+        float t = 1.0f - distSquared*inverseRadiusSquared;
+        t = t > 0.0f ? t : 0.0f;
+        return t*t;
+    }
+
     vec2 position;
+    float influenceRadius;
+    float inverseRadiusSquared; //0 för globala krafter
 private:
     float size;
     Color color;
@@ -0,0 +1,61 @@
+//
+//  forceField.hpp
+//  ParticleSystem
+//
+
+#ifndef forceField_hpp
+#define forceField_hpp
+
+#include "force.h"
+#include "util/vec2.h"
+#include <cstddef>
+#include <vector>
+
+/// A 2D vector field that caches the summed contribution of all static forces on a
+/// regular grid of nodes. Particles sample the grid with bilinear interpolation, so the
+/// cost per particle is constant no matter how many forces there are. The accuracy is
+/// controlled by the resolution of the grid.
+class ForceField {
+public:
+    /**
+     * \param inResolution The number of grid nodes along each axis
+     * \param inDomainMin The lower left corner of the area covered by the grid
+     * \param inDomainMax The upper right corner of the area covered by the grid
+     * \pre \p inResolution must be at least 2
+     */
+    ForceField(int inResolution = 128, vec2 inDomainMin = {-1.0f, -1.0f},
+               vec2 inDomainMax = {1.0f, 1.0f});
+
+    /// Changes the number of nodes along each axis. The field is rebuilt on the next bake
+    void setResolution(int inResolution);
+    int getResolution() const;
+
+    /// Flags the field as out of date, has to be called whenever the set of forces changes
+    void markDirty();
+    bool isDirty() const;
+
+    /// Evaluates all \p forces at every grid node and stores the summed result
+    void bake(const std::vector<Force*>& forces);
+
+    /// Returns the bilinearly interpolated force at \p position. Positions outside of the
+    /// domain are clamped to its border
+    vec2 sample(vec2 position) const;
+
+    /**
+     * Samples the field for \p count positions and adds the result to \p forces. Uses
+     * SSE when available and processes four particles at a time.
+     *
+     * \pre The field has been baked since the last call to markDirty
+     */
+    void accumulate(const vec2* positions, vec2* forces, std::size_t count) const;
+
+private:
+    int resolution;
+    vec2 domainMin;
+    vec2 domainMax;
+    vec2 inverseCellSize;
+    bool dirty = true;
+    std::vector<vec2> nodes;
+};
+
+#endif /* forceField_hpp */
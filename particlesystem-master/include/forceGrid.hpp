@@ -0,0 +1,77 @@
+//
+//  forceGrid.hpp
+//  ParticleSystem
+//
+
+#ifndef forceGrid_hpp
+#define forceGrid_hpp
+
+#include "gravityWell.hpp"
+#include "wind.hpp"
+#include "util/vec2.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A coarse uniform grid that bins every force with a finite influence radius into the
+/// cells its radius overlaps. Particles are sorted into the same cells, and each cell's
+/// particles are evaluated as one block against only the forces binned into that cell.
+/// Global forces (radius 0) are still evaluated for every particle.
+class ForceGrid {
+public:
+    /**
+     * \param inCellsPerAxis The number of cells along each axis
+     * \param inDomainMin The lower left corner of the area covered by the grid
+     * \param inDomainMax The upper right corner of the area covered by the grid
+     * \pre \p inCellsPerAxis must be at least 1
+     */
+    ForceGrid(int inCellsPerAxis = 16, vec2 inDomainMin = {-1.0f, -1.0f},
+              vec2 inDomainMax = {1.0f, 1.0f});
+
+    void setCellsPerAxis(int inCellsPerAxis);
+    int getCellsPerAxis() const;
+
+    /// Flags the bins as out of date, has to be called whenever the set of forces changes
+    void markDirty();
+    bool isDirty() const;
+
+    /// Sorts \p wells and \p winds into the cells overlapped by their influence radius
+    void build(const std::vector<GravityWell*>& wells, const std::vector<Wind*>& winds,
+               bool preciseGravity);
+
+    /**
+     * Adds the force acting on each of the \p count \p positions to \p forces, evaluating
+     * only the forces that overlap the cell of each particle
+     *
+     * \pre The grid has been built since the last call to markDirty
+     */
+    void accumulate(const vec2* positions, vec2* forces, std::size_t count);
+
+private:
+    struct Cell {
+        GravityKernel gravity;
+        std::vector<Wind*> winds;
+        bool empty = true;
+    };
+
+    int cellIndex(vec2 position) const;
+
+    int cellsPerAxis;
+    vec2 domainMin;
+    vec2 domainMax;
+    vec2 inverseCellSize;
+    bool dirty = true;
+
+    std::vector<Cell> cells;
+    GravityKernel globalGravity;
+    std::vector<Wind*> globalWinds;
+
+    //Återanvänds mellan anrop för att slippa allokera varje frame
+    std::vector<std::uint32_t> particleCell;
+    std::vector<std::uint32_t> cellStart;
+    std::vector<std::uint32_t> order;
+    std::vector<vec2> blockPositions;
+    std::vector<vec2> blockForces;
+};
+
+#endif /* forceGrid_hpp */
@@ -0,0 +1,88 @@
+//
+//  framePipeline.hpp
+//  ParticleSystem
+//
+
+#ifndef framePipeline_hpp
+#define framePipeline_hpp
+
+#include "particlesystem.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs the simulation of a ParticleSystem on its own thread so that simulating frame N+1
+ * overlaps with uploading and drawing frame N on the thread that owns the window. Each
+ * simulated step is packed into a RenderData buffer and queued for drawing.
+ *
+ * The depth is the number of steps the simulation may run ahead of what is on screen. A
+ * depth of 0 runs update and render one after the other on the calling thread, as without
+ * a pipeline. With a depth of D the frame drawn in a call to runFrame is the one simulated
+ * D calls earlier, so the added latency is D frames, and the time per frame approaches
+ * max(simulation, rendering) instead of their sum. The depth is limited to 0-2.
+ *
+ * While the pipeline runs, the ParticleSystem must only be changed through execute.
+ */
+class FramePipeline {
+public:
+    /// The parameters of one call to ParticleSystem::update
+    struct Step {
+        float dt;
+        float numberOfSpawnDirections;
+        float angle;
+    };
+
+    static constexpr int MaxDepth = 2;
+
+    /// \param inDraw Called on the thread that calls runFrame to draw a finished frame
+    explicit FramePipeline(ParticleSystem& inSystem, int inDepth = 1,
+                           std::function<void(const RenderData&)> inDraw = &ParticleSystem::draw);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    /// Waits for the frames in flight, which are discarded, and changes the depth
+    void setDepth(int inDepth);
+    int getDepth() const;
+
+    /// Runs \p command on the particle system right before the next simulation step
+    void execute(std::function<void(ParticleSystem&)> command);
+
+    /// Starts simulating \p step and draws the oldest finished frame, if there is one
+    void runFrame(const Step& step);
+
+    /// The number of particles in the frame that was drawn last
+    std::size_t getDrawnParticleCount() const;
+
+private:
+    void simulationLoop();
+    void runCommands(std::vector<std::function<void(ParticleSystem&)>>& commands);
+    void start();
+    void stop();
+
+    ParticleSystem& system;
+    std::function<void(const RenderData&)> draw;
+    int depth;
+    std::size_t drawnParticles = 0;
+
+    std::mutex mutex;
+    std::condition_variable stepQueued;
+    std::condition_variable frameFinished;
+    std::vector<std::function<void(ParticleSystem&)>> commands;
+    std::deque<Step> steps;
+    std::vector<std::unique_ptr<RenderData>> buffers;
+    std::vector<RenderData*> freeBuffers;
+    std::deque<RenderData*> finishedFrames;
+    int framesInFlight = 0;
+    bool stopping = false;
+    std::thread simulationThread;
+};
+
+#endif /* framePipeline_hpp */
@@ -13,9 +13,43 @@
 
 class GravityWell: public Force {
     public:
-        GravityWell(vec2 inPosition, float inSize, Color inColor);
+        GravityWell(vec2 inPosition, float inSize, Color inColor, float inSoftening = 0.01f, float inRadius = 0.0f);
         vec2 computeForce(vec2 particlePosition);
+
+        /// The softening length keeps the force finite close to the well by evaluating
+        /// C*dist/(|dist|^2 + softening^2)^(3/2) instead of C*dist/|dist|^3
+        void setSoftening(float inSoftening);
+        float getSoftening() const;
+        float getStrength() const;
     private:
+        float strength = 1.0f; //gravitationskonstant, värdet kan sättas fritt
+        float softening;
+};
+
+/// Evaluates a whole set of gravity wells for blocks of particles at once. The wells are
+/// stored as separate x, y, strength, softening, and radius arrays and every particle-well pair
+/// costs a single reciprocal square root.
+class GravityKernel {
+public:
+    /// Copies the parameters of \p wells, has to be called again when the wells change
+    void setWells(const std::vector<GravityWell*>& wells);
+
+    /// In the fast mode (default) the reciprocal square root is the hardware estimate
+    /// refined with one Newton-Raphson step (~22 bits). The precise mode uses a full
+    /// square root and division instead
+    void setPrecise(bool inPrecise);
+    bool isPrecise() const;
+
+    /// Adds the summed force of all wells on each of the \p count \p positions to \p forces
+    void accumulate(const vec2* positions, vec2* forces, std::size_t count) const;
+
+private:
+    bool precise = false;
+    std::vector<float> wellX;
+    std::vector<float> wellY;
+    std::vector<float> wellStrength;
+    std::vector<float> wellSofteningSquared;
+    std::vector<float> wellInverseRadiusSquared;
 };
 
 #endif /* gravityWell_hpp */
@@ -8,7 +8,7 @@
 #ifndef particle_h
 #define particle_h
 
-#include "util/color.h"
+#include "particleArchetype.hpp"
 #include "util/rendering.h"
 #include "util/vec2.h"
 #include <vector>
@@ -17,22 +17,23 @@
 
 class Particle {
 public:
-    Particle(vec2 inPosition, float inRadius, Color inColor, float inMass, vec2 inVelocity);
+    /// \param inArchetype The index of the particle's archetype in the owning system's table
+    Particle(vec2 inPosition, vec2 inVelocity, std::uint32_t inArchetype, float inLifetime);
 
     float lifetime;
     vec2 position;
     
-    void updateSingleParticle(float dt, vec2 inputForce);
-    float getLifeTime();
-    rendering::ParticleInfo toParticleInfo();
-    vec2 getPosition();
+    void updateSingleParticle(float dt, vec2 inputForce, float inverseMass);
+    float getLifeTime() const;
+    rendering::ParticleInfo toParticleInfo(const ParticleArchetypeTable& archetypes) const;
+    vec2 getPosition() const;
+    vec2 getVelocity() const;
+    std::uint32_t getArchetype() const;
     
 private:
     
-    float radius;
-    Color color;
-    float mass;
     vec2 velocity;
+    std::uint32_t archetype;
 };
 
 
@@ -0,0 +1,64 @@
+//
+//  particleArchetype.hpp
+//  ParticleSystem
+//
+
+#ifndef particleArchetype_hpp
+#define particleArchetype_hpp
+
+#include "util/color.h"
+#include <cstdint>
+#include <vector>
+
+/// The properties that are shared by all particles created by the same kind of emitter.
+/// Particles only store the index of their archetype in a ParticleArchetypeTable.
+struct ParticleArchetype {
+    float radius;
+    Color color;
+    float inverseMass;
+    /// The lifetime of a newly created particle in seconds
+    float lifetime;
+};
+
+/// True if all properties of \p a and \p b are equal
+bool isSame(const ParticleArchetype& a, const ParticleArchetype& b);
+
+/// Owns the archetypes referenced by the particles of one ParticleSystem
+class ParticleArchetypeTable {
+public:
+    /**
+     * Adds \p archetype to the table and returns its index. If an identical archetype has
+     * already been added, the index of the existing entry is returned instead, so emitters
+     * with the same settings share one entry.
+     */
+    std::uint32_t add(const ParticleArchetype& archetype);
+
+    /**
+     * Adds \p archetype as a new entry even if an identical archetype exists. The entry is
+     * never returned by add, so the particles that refer to it can be told apart from the
+     * particles of all other emitters. Entries freed by release are reused first.
+     */
+    std::uint32_t addUnique(const ParticleArchetype& archetype);
+
+    /// Frees an entry from addUnique for reuse, no particle may refer to it anymore
+    void release(std::uint32_t index);
+
+    /// False for the entries that were created by addUnique
+    bool isShared(std::uint32_t index) const;
+
+    const ParticleArchetype& operator[](std::uint32_t index) const;
+
+    /// Returns 1 / inverseMass of the archetype at \p index, cached when it was added
+    float getMass(std::uint32_t index) const;
+
+    std::size_t size() const;
+    void clear();
+
+private:
+    std::vector<ParticleArchetype> archetypes;
+    std::vector<float> masses;
+    std::vector<bool> shared;
+    std::vector<std::uint32_t> released;
+};
+
+#endif /* particleArchetype_hpp */
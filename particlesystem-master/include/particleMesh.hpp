@@ -0,0 +1,120 @@
+//
+//  particleMesh.hpp
+//  ParticleSystem
+//
+
+#ifndef particleMesh_hpp
+#define particleMesh_hpp
+
+#include "util/threadpool.h"
+#include "util/vec2.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * A particle-mesh (PM) gravity solver. Point masses (gravity wells and massive particles)
+ * are deposited onto a regular grid with cloud-in-cell weights, the 2D Poisson equation
+ * for the gravitational potential is solved on the grid with a multigrid V-cycle, and the
+ * gradient of the potential is interpolated back to the particles with the same weights.
+ * The cost is linear in the number of particles plus the grid size and does not depend on
+ * the number of wells.
+ *
+ * Since the Poisson equation is solved in 2D, the far field of a point mass falls off
+ * as 1/r instead of the 1/r^2 of GravityWell. The potential is fixed to zero on the
+ * border of the domain, so the domain should be somewhat larger than the visible area.
+ *
+ * Gravity wells are solved into a separate field. A well pulls with the same force on
+ * every particle regardless of its mass, like GravityWell does, and the field is scaled
+ * so that the two agree at WellMatchingDistance from the well. The well field is only
+ * solved again when the wells change.
+ */
+class ParticleMesh {
+public:
+    /**
+     * \param inCellsPerAxis The number of grid cells along each axis
+     * \param inDomainMin The lower left corner of the area covered by the grid
+     * \param inDomainMax The upper right corner of the area covered by the grid
+     * \pre \p inCellsPerAxis must be a power of two and at least 4
+     */
+    ParticleMesh(int inCellsPerAxis = 128, vec2 inDomainMin = {-1.5f, -1.5f},
+                 vec2 inDomainMax = {1.5f, 1.5f});
+
+    void setCellsPerAxis(int inCellsPerAxis);
+    int getCellsPerAxis() const;
+
+    /// The potential is only solved every \p steps calls to update. In between, the
+    /// previous solution is reused for the force interpolation
+    void setUpdateInterval(int steps);
+    void setGravitationalConstant(float G);
+
+    /// The distance from a well at which its mesh force equals the force of GravityWell.
+    /// Closer to the well the mesh force is weaker, further away it is stronger
+    static constexpr float WellMatchingDistance = 0.25f;
+
+    /// Replaces the gravity wells, \p strengths are the values of GravityWell::getStrength
+    void setWells(const vec2* positions, const float* strengths, std::size_t count);
+
+    /// Removes all deposited masses
+    void clearMasses();
+    /// Deposits \p count point masses onto the grid with cloud-in-cell weights
+    void depositMasses(const vec2* positions, const float* masses, std::size_t count);
+
+    /// Solves for the potential if the update interval has passed. Has to be called once
+    /// per step after all masses have been deposited
+    void update();
+    /// Returns \c true if the next call to update will solve the potential, so that the
+    /// caller can skip depositing masses otherwise
+    bool needsUpdate() const;
+
+    /**
+     * Adds the gravitational force (mass * acceleration) on each of the \p count particles
+     * to \p forces, plus the force of the wells
+     */
+    void accumulate(const vec2* positions, const float* masses, vec2* forces,
+                    std::size_t count, ThreadPool& pool) const;
+
+private:
+    struct Level {
+        int nodes;              //Antal noder per axel, (celler + 1)
+        float h;                //Avstånd mellan noderna
+        std::vector<float> potential;
+        std::vector<float> rhs;
+        std::vector<float> residual;
+    };
+
+    void smooth(Level& level, int iterations) const;
+    void computeResidual(Level& level) const;
+    void restrictResidual(const Level& fine, Level& coarse) const;
+    void prolongAndCorrect(const Level& coarse, Level& fine) const;
+    void vCycle(std::size_t levelIndex);
+    void deposit(std::vector<float>& target, const vec2* positions, const float* masses,
+                 std::size_t count) const;
+    /// Solves laplace(potential) = scale*source starting from \p potential, which is
+    /// left holding the solution, and writes -grad(potential) to \p field
+    void solve(const std::vector<float>& source, float scale, std::vector<float>& potential,
+               std::vector<vec2>& field);
+
+    int cellsPerAxis;
+    vec2 domainMin;
+    vec2 domainMax;
+    float cellSize;
+    int updateInterval = 1;
+    int stepsSinceUpdate = 0;
+    bool hasSolution = false;
+    float gravitationalConstant = 0.01f;
+
+    std::vector<float> density;
+    std::vector<float> potential;       //Förra lösningen, startgissning för nästa
+    std::vector<Level> levels;          //levels[0] är den finaste nivån
+    std::vector<vec2> acceleration;     //-grad(potential) i varje nod
+
+    //Brunnarna sparas så att de kan läggas på nytt om upplösningen ändras
+    std::vector<vec2> wellPositions;
+    std::vector<float> wellStrengths;
+    std::vector<float> wellDensity;
+    std::vector<float> wellPotential;
+    std::vector<vec2> wellForce;        //Kraft per nod, oberoende av partikelns massa
+    bool wellsChanged = false;
+};
+
+#endif /* particleMesh_hpp */
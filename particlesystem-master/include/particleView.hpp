@@ -0,0 +1,47 @@
+//
+//  particleView.hpp
+//  ParticleSystem
+//
+
+#ifndef particleView_hpp
+#define particleView_hpp
+
+#include "particle.h"
+#include "particleArchetype.hpp"
+#include <cassert>
+#include <cstddef>
+
+/// A read-only window onto the particles of a ParticleSystem that does not copy them. The
+/// view is cheap to create and to pass by value, but it is invalidated by the next call to
+/// update (or any other call that changes the set of particles) of the system it came from.
+class ParticleView {
+public:
+    ParticleView() = default;
+    ParticleView(const Particle* inParticles, std::size_t inCount,
+                 const ParticleArchetypeTable* inArchetypes)
+        : particles(inParticles), count(inCount), archetypes(inArchetypes) {}
+
+    const Particle& operator[](std::size_t index) const {
+        assert(index < count);
+        return particles[index];
+    }
+
+    const Particle* begin() const { return particles; }
+    const Particle* end() const { return particles + count; }
+    const Particle* data() const { return particles; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /// The table that the archetype indices of the particles refer to
+    const ParticleArchetypeTable& getArchetypes() const {
+        assert(archetypes != nullptr);
+        return *archetypes;
+    }
+
+private:
+    const Particle* particles = nullptr;
+    std::size_t count = 0;
+    const ParticleArchetypeTable* archetypes = nullptr;
+};
+
+#endif /* particleView_hpp */
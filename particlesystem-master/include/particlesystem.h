@@ -7,25 +7,228 @@
 #include "force.h"
 #include "emitter.h"
 #include "particle.h"
+#include "particleView.hpp"
+#include "forceField.hpp"
+#include "forceGrid.hpp"
+#include "barnesHut.hpp"
+#include "particleMesh.hpp"
+#include "gravityWell.hpp"
+#include "wind.hpp"
+#include "uniform.hpp"
+#include "directional.hpp"
+#include "shapeEmitter.hpp"
+#include "subEmitter.hpp"
+#include "util/pool.h"
+#include "util/memory.h"
+#include "util/taskgraph.h"
+#include <cstdint>
 #include <vector>
 
+/// Everything that is needed to draw one frame of a ParticleSystem
+struct RenderData {
+    std::vector<rendering::ParticleInfo> particles;
+    std::vector<rendering::EmitterInfo> emitters;
+    std::vector<rendering::ForceInfo> forces;
+};
+
+/// Refers to an emitter owned by a ParticleSystem. The handle detects if the emitter has
+/// been removed, even if a new emitter has taken its place
+struct EmitterHandle {
+    enum class Type : std::uint8_t { Uniform, Directional, Shape };
+    Type type;
+    std::uint32_t index;
+    std::uint32_t generation;
+};
+
+/// Refers to a force owned by a ParticleSystem, see EmitterHandle
+struct ForceHandle {
+    enum class Type : std::uint8_t { GravityWell, Wind };
+    Type type;
+    std::uint32_t index;
+    std::uint32_t generation;
+};
+
 class ParticleSystem {
 public:
     ParticleSystem();
 
     void update(float dt, float numberOfSpawnDirections, float angle);
+    /// Same as update followed by pack, but packs each chunk of particles as soon as it
+    /// has been integrated instead of waiting for the whole update
+    void updateAndPack(float dt, float numberOfSpawnDirections, float angle, RenderData& out);
     void render();
-    void addUniform(vec2 inPosition);
-    void addDirectional(vec2 inPosition);
-    void addGravityWell(vec2 inPosition);
-    void addWind(vec2 inPosition);
-    std::vector<Particle> ParticleSystem::getParticles();
-    //void removeLatestEmitter();
+
+    /// Copies the drawable state into \p out, reusing its memory. Does not call OpenGL, so
+    /// it can run on any thread
+    void pack(RenderData& out);
+    /// Submits \p data to layer 0 of the default renderer, see submit
+    static void draw(const RenderData& data);
+    /// Submits \p data to \p layer of \p renderer. Can be called from any thread, so
+    /// several systems can be simulated and submitted concurrently
+    static void submit(const RenderData& data, rendering::Renderer& renderer, int layer);
+    EmitterHandle addUniform(vec2 inPosition);
+    EmitterHandle addDirectional(vec2 inPosition);
+    /// Adds an emitter that spreads its particles over \p shape, centred on \p inPosition
+    EmitterHandle addShape(vec2 inPosition, const EmitterShape& shape);
+    /// A \p radius of 0 adds a global force, otherwise the force only acts within radius
+    ForceHandle addGravityWell(vec2 inPosition, float radius = 0.0f);
+    /// \p angle is the direction the wind blows in, in radians
+    ForceHandle addWind(vec2 inPosition, float radius = 0.0f, float angle = 3.141592654f / 4);
+    /// Returns a view of the current particles without copying them. The view is valid
+    /// until the next call to update or clear
+    ParticleView getParticles() const;
+    /// Returns a copy of the current particles that stays valid after the next update
+    std::vector<Particle> snapshotParticles() const;
+
+    /// Removes an emitter in constant time, the particles it has created live on. Returns
+    /// false if the handle no longer refers to an emitter. The archetypes and sub-emitters
+    /// that only this emitter used are reused once none of its particles are left, which
+    /// is checked by scanning the particles while any of them are waiting
+    bool removeEmitter(EmitterHandle handle);
+    /// Removes a force in constant time, returns false if it was already removed
+    bool removeForce(ForceHandle handle);
+    /// Whether the handle refers to an emitter or force that has not been removed
+    bool isValid(EmitterHandle handle) const;
+    bool isValid(ForceHandle handle) const;
+
+    /// \pre isValid(handle)
+    Emitter& getEmitter(EmitterHandle handle);
+    /// \pre isValid(handle)
+    Force& getForce(ForceHandle handle);
+    std::size_t getNumberOfEmitters() const;
+    std::size_t getNumberOfForces() const;
+    /// The number of archetype and sub-emitter entries, including freed ones waiting for reuse
+    std::size_t getNumberOfArchetypes() const;
+    std::size_t getNumberOfSubEmitters() const;
+
+    /// Destroys all emitters, forces, and particles
+    void clear();
+
+    /// The seed of the random streams, used by emitters whose jitter is set afterwards
+    void setSeed(std::uint64_t inSeed);
+    /**
+     * Randomizes the particles of an emitter. The random values of each particle depend
+     * only on the seed, the emitter and how many particles it has created before, so runs
+     * are reproducible with any number of threads. A color jitter registers a few
+     * archetype variants with randomly shifted colors.
+     */
+    void setEmitterJitter(EmitterHandle handle, const EmitterJitter& jitter);
+
+    /**
+     * Makes the particles of an emitter burst into new particles where they die. The first
+     * stage triggers on the particles of the emitter and every further stage on the
+     * particles of the stage before, so effects can be chained. The deaths of each update
+     * are collected in a batch and spawned after the emitters, in the same update. The
+     * emitter and every stage get archetypes of their own, so the bursts only apply to
+     * this emitter, also when other emitters create identical particles.
+     *
+     * \return The number of stages that were added. The chain stops at a stage that creates
+     *         the same particles as the emitter or an earlier stage, which would loop forever
+     */
+    std::size_t addSubEmitters(EmitterHandle handle, const std::vector<SubEmitterDescription>& stages);
+
+    /// Lets particles sample a grid baked from all forces instead of evaluating every
+    /// force for every particle. The grid is rebuilt whenever a force is added
+    void setForceFieldEnabled(bool enabled);
+    bool isForceFieldEnabled() const;
+    void setForceFieldResolution(int resolution);
+
+    /// Softening length used by all gravity wells, see GravityWell::setSoftening
+    void setGravitySoftening(float softening);
+    /// Chooses between the fast (rsqrt + Newton step) and precise gravity kernel
+    void setPreciseGravity(bool precise);
+
+    /// Bins forces with a finite radius into a coarse grid so that particles only
+    /// evaluate the forces that can reach them
+    void setForceCullingEnabled(bool enabled);
+
+    /// Lets the particles attract each other through their masses. The forces are
+    /// approximated with a Barnes-Hut tree using the given opening angle
+    void setNBodyEnabled(bool enabled);
+    void setNBodyOpeningAngle(float theta);
+    void setNBodyGravitationalConstant(float G);
+
+    /// Replaces the direct evaluation of the gravity wells and the N-body forces with a
+    /// particle-mesh solver. The grid resolution must be a power of two, and the
+    /// potential is only recomputed every \p steps updates
+    void setParticleMeshEnabled(bool enabled);
+    void setParticleMeshResolution(int cellsPerAxis);
+    void setParticleMeshUpdateInterval(int steps);
     
 private:
-    std::vector<Force*> forces;
-    std::vector<Emitter*> emitters;
-    std::vector<Particle> particles;
+    /// A half-open range [first, last) of particles or emitters
+    struct Range {
+        std::size_t first;
+        std::size_t last;
+    };
+
+    /// Runs one update as a task graph over chunks of particles, packs into \p out if set
+    void runUpdate(float dt, float numberOfSpawnDirections, float angle, RenderData* out);
+    void packParticles(const memory::LargeVector<Particle>& source, std::size_t first,
+                       std::size_t last, RenderData& out) const;
+    void packEmittersAndForces(RenderData& out) const;
+    void forcesChanged();
+    std::vector<Force*> collectForces();
+    /// The index of the sub-emitter triggered by the death of a particle, or -1
+    std::int32_t subEmitterFor(std::uint32_t archetype) const;
+
+    /// Private archetypes and sub-emitter stages that no emitter creates anymore
+    struct Retired {
+        std::vector<std::uint32_t> archetypes;
+        std::vector<std::int32_t> stages;
+    };
+    /// Adds the stages that follow \p archetype and the archetypes they create to \p out
+    void collectChain(std::uint32_t archetype, Retired& out) const;
+    /// Frees the retired archetypes and stages that no living particle refers to anymore
+    void reclaimRetired();
+
+    //Emitters och forces lagras per typ i sammanhängande minne, ägda av systemet
+    Pool<Uniform> uniforms;
+    Pool<Directional> directionals;
+    Pool<ShapeEmitter> shapes;
+    Pool<GravityWell> gravityWells;
+    Pool<Wind> winds;
+    //Stora arrayer per partikel, se memory::Policy för huge pages och NUMA
+    memory::LargeVector<Particle> particles;
+    //De levande partiklarna kopieras hit varje uppdatering och byter sen plats med particles
+    memory::LargeVector<Particle> backParticles;
+    ParticleArchetypeTable archetypes;
+    std::uint64_t seed = 1;
+
+    GravityKernel gravityKernel;
+    float gravitySoftening = 0.01f;
+
+    ForceField forceField;
+    bool forceFieldEnabled = false;
+    ForceGrid forceGrid;
+    bool forceCullingEnabled = false;
+    BarnesHutTree barnesHutTree;
+    bool nBodyEnabled = false;
+    memory::LargeVector<float> massScratch;
+    ParticleMesh particleMesh;
+    bool particleMeshEnabled = false;
+    memory::LargeVector<vec2> positionScratch;
+    memory::LargeVector<vec2> forceScratch;
+    std::vector<Emitter*> emitterScratch;
+    std::vector<std::size_t> spawnOffsets;
+    std::vector<std::size_t> chunkOffsets;
+    std::vector<Range> spawnGroups;
+    std::vector<Range> producedRanges;
+    std::vector<SubEmitter> subEmitters;
+    //Index i subEmitters per arketyp, -1 om partiklarna bara försvinner. Bara emittrar och
+    //steg med egna arketyper (addUnique) har sub-emitters
+    std::vector<std::int32_t> subEmitterOfArchetype;
+    //Väntar på att deras sista partiklar ska dö, sen återanvänds de
+    std::vector<Retired> retired;
+    std::vector<std::int32_t> freeSubEmitters;
+    std::vector<DeathEvent> deathEvents;
+    std::vector<std::size_t> deathOffsets;
+    std::vector<std::size_t> burstOffsets;
+    std::vector<std::vector<float>> burstScratch;
+    //Hur många partiklar alla sub-emitters skapat, index i deras slumpade strömmar
+    std::uint64_t numberOfBurstParticles = 0;
+    TaskGraph updateGraph;
+    RenderData renderData;
 };
 
 #endif // __PARTICLESYSTEM_H__
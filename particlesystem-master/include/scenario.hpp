@@ -0,0 +1,111 @@
+//
+//  scenario.hpp
+//  ParticleSystem
+//
+
+#ifndef scenario_hpp
+#define scenario_hpp
+
+#include "particlesystem.h"
+#include "util/vec2.h"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * A reproducible scene: the emitters and forces of a particle system, the settings it runs
+ * with and how long it runs. Scenarios are written in a small line based text format, see
+ * parseScenario, or taken from the built-in presets.
+ */
+struct Scenario {
+    struct EmitterDescription {
+        EmitterHandle::Type type;
+        vec2 position;
+        int rate = 1;
+        EmitterJitter jitter;
+        /// The stages passed to ParticleSystem::addSubEmitters, empty for none
+        std::vector<SubEmitterDescription> bursts;
+        /// Only used by shape emitters
+        EmitterShape shape;
+    };
+
+    struct ForceDescription {
+        ForceHandle::Type type;
+        vec2 position;
+        float radius = 0.0f;
+        /// Only used by winds
+        float angle = 3.141592654f / 4;
+    };
+
+    std::string name;
+    std::uint32_t seed = 1;
+
+    float timestep = 1.0f / 60.0f;
+    float duration = 10.0f;
+    float numberOfSpawnDirections = 6.0f;
+    float angle = 3.141592654f / 4;
+
+    bool forceField = false;
+    bool forceCulling = false;
+    bool nBody = false;
+    bool particleMesh = false;
+    bool preciseGravity = false;
+    float gravitySoftening = 0.01f;
+
+    std::vector<EmitterDescription> emitters;
+    std::vector<ForceDescription> forces;
+};
+
+/**
+ * Reads a scenario from \p input. Each line holds one command, everything after a # is a
+ * comment:
+ *
+ *   name <text>                     seed <integer>
+ *   timestep <seconds>              duration <seconds>
+ *   spawnDirections <count>         angle <radians>
+ *   set <forceField|forceCulling|nBody|particleMesh|preciseGravity> <on|off>
+ *   set gravitySoftening <value>
+ *
+ *   uniform <x> <y> [rate]          directional <x> <y> [rate]
+ *   gravity <x> <y> [radius]        wind <x> <y> [angle] [radius]
+ *
+ *   line <x0> <y0> <x1> <y1> [rate]              disc <x> <y> <radius> [rate]
+ *   annulus <x> <y> <inner> <outer> [rate]       rectangle <x> <y> <width> <height> [rate]
+ *   polyline <rate> <x0> <y0> <x1> <y1> [<x> <y> ...]
+ *
+ *   jitter <angle> <speed> <lifetime> <color>
+ *   burst <count> <speed> <inheritVelocity> <lifetime>      burst off
+ *
+ * The jitter line applies to all emitters that follow it, see EmitterJitter. Each burst
+ * line adds a stage to the chain of sub-emitters of the emitters that follow, the first
+ * stage bursts where the emitter's particles die and every further stage where the
+ * particles of the stage before die. burst off ends the chain.
+ *
+ * Many objects can be generated at once, where <kind> is one of uniform, directional,
+ * gravity or wind and the optional parameters are the ones listed above:
+ *
+ *   random <kind> <count> [parameters]          uniformly random positions
+ *   ring <kind> <count> <ringRadius> [params]   evenly spaced on a circle
+ *   grid <kind> <columns> <rows> [parameters]   evenly spaced on a grid
+ *
+ * Generated objects are placed inside [-0.9, 0.9]. Random positions depend only on the
+ * seed line that precedes them, so a scenario always expands to the same scene.
+ *
+ * \throw std::runtime_error If a line cannot be parsed, the message names the line
+ */
+Scenario parseScenario(std::istream& input);
+
+/// Reads the scenario file at \p path, throws std::runtime_error if it cannot be read
+Scenario loadScenario(const std::string& path);
+
+/// The names of the built-in presets
+std::vector<std::string> getScenarioPresets();
+
+/// Returns the built-in preset \p name, throws std::runtime_error for unknown names
+Scenario getScenarioPreset(const std::string& name);
+
+/// Removes everything from \p system and sets it up as described by \p scenario
+void applyScenario(const Scenario& scenario, ParticleSystem& system);
+
+#endif /* scenario_hpp */
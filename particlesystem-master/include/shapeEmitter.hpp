@@ -0,0 +1,91 @@
+//
+//  shapeEmitter.hpp
+//  ParticleSystem
+//
+
+#ifndef shapeEmitter_hpp
+#define shapeEmitter_hpp
+
+#include "emitter.h"
+#include "util/random.h"
+#include "util/vec2.h"
+#include <cstdint>
+#include <vector>
+
+/// The area or curve that a ShapeEmitter spawns its particles on, relative to the
+/// position of the emitter
+struct EmitterShape {
+    enum class Type : std::uint8_t { Line, Disc, Annulus, Rectangle, Polyline };
+
+    Type type = Type::Disc;
+    /// The end points of a line or the corners of a polyline
+    std::vector<vec2> points;
+    /// Discs only use the outer radius
+    float innerRadius = 0.0f;
+    float outerRadius = 0.1f;
+    /// Half the width and height of a rectangle
+    vec2 halfSize = {0.1f, 0.1f};
+
+    static EmitterShape line(vec2 from, vec2 to);
+    static EmitterShape disc(float radius);
+    static EmitterShape annulus(float innerRadius, float outerRadius);
+    static EmitterShape rectangle(vec2 halfSize);
+    /// \pre At least two points
+    static EmitterShape polyline(std::vector<vec2> points);
+};
+
+/**
+ * Spawns particles spread uniformly over a shape, so that one emitter can replace the
+ * hundreds of point emitters that would otherwise be needed to fill an area. Particles
+ * leave the shape outwards: along the normal of lines and polylines and away from the
+ * centre for the other shapes. With setDirectionalAngle they all use the angle of the
+ * directional emitters instead.
+ *
+ * Everything that depends on the shape is precomputed, so each sample costs the same: a
+ * polyline picks its segment from an alias table over the segment lengths, discs and
+ * annuli invert their area CDF for the radius and look up the direction in a table. The
+ * random numbers of a whole update are generated in one batch.
+ */
+class ShapeEmitter: public Emitter{
+public:
+    ShapeEmitter(vec2 inPosition, float inSize, Color inColor, const EmitterShape& inShape);
+    void emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle);
+    ParticleArchetype getParticleArchetype() const;
+
+    const EmitterShape& getShape() const;
+    void setSpeed(float inSpeed);
+    /// Makes the particles use the angle passed to emitParticles instead of leaving outwards
+    void setDirectionalAngle(bool enabled);
+
+    /// Sets the stream that the positions are sampled from, see Emitter::setJitter
+    void setStream(const rng::Stream& inStream);
+
+    /// The number of entries in the direction table of discs and annuli
+    static constexpr int DirectionTableSize = 4096;
+
+private:
+    void buildTables();
+
+    EmitterShape shape;
+    float speed = 0.3f;
+    bool directionalAngle = false;
+    rng::Stream stream;
+    //Hur många partiklar som skapats, index i den slumpade strömmen
+    std::uint64_t numberOfSampled = 0;
+
+    //Polylinje: ett segment per par av punkter, med enhetsnormal och aliastabell över längderna
+    std::vector<vec2> segmentNormals;
+    std::vector<float> aliasProbability;
+    std::vector<std::uint32_t> alias;
+    //Cirkel och ring: enhetsvektorer jämnt runt varvet
+    std::vector<vec2> directions;
+
+    //Slumptal och de samplade kolumnerna, återanvänds mellan uppdateringar
+    std::vector<float> randomScratch;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> directionX;
+    std::vector<float> directionY;
+};
+
+#endif /* shapeEmitter_hpp */
@@ -0,0 +1,71 @@
+//
+//  subEmitter.hpp
+//  ParticleSystem
+//
+
+#ifndef subEmitter_hpp
+#define subEmitter_hpp
+
+#include "particle.h"
+#include "particleArchetype.hpp"
+#include "util/random.h"
+#include "util/vec2.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A particle that ran out of lifetime, collected while the dead particles are removed
+struct DeathEvent {
+    vec2 position;
+    vec2 velocity;
+    std::uint32_t archetype;
+};
+
+/// The burst of particles that a sub-emitter creates where a particle dies
+struct SubEmitterDescription {
+    /// The number of particles per burst, sent out evenly around a circle
+    int count = 16;
+    float speed = 0.2f;
+    /// The largest relative change of the speed of each particle, 0.2 means +-20%
+    float speedJitter = 0.0f;
+    /// How much of the velocity of the dying particle the burst keeps
+    float inheritVelocity = 0.5f;
+    /// The look, mass and lifetime of the particles in the burst
+    ParticleArchetype archetype = {2.0f, {1.0f, 0.8f, 0.3f}, 1.0f/0.02f, 1.0f};
+};
+
+/**
+ * Turns a batch of death events into bursts of new particles. There are no callbacks per
+ * particle: the directions of the burst are precomputed and the random speeds of a whole
+ * batch are generated at once, so the particle system can spawn tens of thousands of
+ * bursts per update from many threads.
+ */
+class SubEmitter {
+public:
+    /// \param inArchetype The index of description.archetype in the owning system's table
+    SubEmitter(const SubEmitterDescription& inDescription, std::uint32_t inArchetype, const rng::Stream& inStream);
+
+    /// The number of particles created per death event
+    std::size_t getBurstSize() const;
+    std::uint32_t getArchetype() const;
+
+    /**
+     * Writes getBurstSize() particles per event to \p out. Only reads the sub-emitter, so
+     * several batches can be spawned concurrently.
+     *
+     * \param firstParticle The index of the first created particle in the random stream,
+     *        the result does not depend on how the events are split into batches
+     * \param scratch Memory for the random numbers, reused between calls
+     */
+    void spawn(const DeathEvent* events, std::size_t numberOfEvents, std::uint64_t firstParticle,
+               Particle* out, std::vector<float>& scratch) const;
+
+private:
+    SubEmitterDescription description;
+    std::uint32_t archetype;
+    rng::Stream stream;
+    //Riktningarna gånger farten, beräknas en gång
+    std::vector<vec2> velocities;
+};
+
+#endif /* subEmitter_hpp */
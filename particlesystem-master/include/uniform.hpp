@@ -11,13 +11,32 @@
 #include <stdio.h>
 #include "emitter.h"
 
+/// Sends particles out in a ring. Every particle leaves at an angle 2*pi/numberOfSpawnDirections
+/// further around than the previous one. No trigonometry is evaluated per particle: a whole
+/// number of directions is read from a precomputed table and any other count rotates a
+/// unit vector by a cached step.
 class Uniform: public Emitter{
 public:
     Uniform(vec2 inPosition, float inSize, Color inColor): Emitter(inPosition, inSize, inColor){};
-    std::vector<Particle> createParticles(float numberOfSpawnDirections, float inAngle);
+    void emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle);
+    ParticleArchetype getParticleArchetype() const;
+
+    /// Rings with more directions than this are rotated instead of read from a table
+    static constexpr int MaxTableSize = 4096;
     
 private:
-    float theta = 0.0f;
+    /// Rebuilds the table or the rotation step, only done when the count changes
+    void setSpawnDirections(float numberOfSpawnDirections);
+
+    float spawnDirections = 0.0f;
+    //Riktningen för den senast skickade partikeln, alltid en enhetsvektor
+    vec2 direction = {1.0f, 0.0f};
+    //cos och sin av vinkelsteget, rotationen är en komplex multiplikation
+    vec2 step = {1.0f, 0.0f};
+    int stepsSinceNormalization = 0;
+    //Används när antalet riktningar är ett heltal, tom annars
+    std::vector<vec2> directionTable;
+    std::size_t tableIndex = 0;
 };
 
 #endif /* uniform_hpp */
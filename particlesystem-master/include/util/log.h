@@ -0,0 +1,167 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+/**
+ * Logging that is cheap enough to use inside the frame loop. A log call only checks the
+ * level and copies the format string pointer and the raw arguments into a lock-free ring
+ * buffer that belongs to the calling thread. A background thread formats the messages and
+ * writes them to stderr, so the calling thread never waits for I/O. If a ring buffer is
+ * full the message is dropped and counted instead of blocking.
+ *
+ * Use the LOG_* macros: their arguments are not evaluated when the level is disabled, and
+ * levels below PARTICLESYSTEM_LOG_LEVEL are removed at compile time.
+ *
+ * The format has to be a string literal using printf conversions. Arguments can be
+ * integers, floating point numbers, pointers and strings. Strings of up to
+ * Argument::MaxStringLength characters are copied into the ring buffer. A message with a
+ * longer string is formatted on the calling thread instead, which costs one allocation
+ * but keeps the whole text.
+ */
+namespace logging {
+
+enum class Level : std::uint8_t { Debug = 0, Info = 1, Warning = 2, Error = 3, None = 4 };
+
+/// Messages below \p level are ignored at runtime, the default is Level::Info
+void setLevel(Level level);
+Level getLevel();
+bool isEnabled(Level level);
+
+/// Blocks until every message logged before the call has been written
+void flush();
+
+/// The number of messages that were dropped because a ring buffer was full
+std::uint64_t getNumberOfDroppedMessages();
+
+/// Receives every formatted message instead of stderr. Called on the background thread,
+/// or on the thread calling flush, but never concurrently
+using Sink = std::function<void(Level level, const std::string& message)>;
+
+/// Replaces the output of the log, an empty \p sink restores stderr. Messages that are
+/// still buffered go to the new sink, call flush first to keep them in the old one
+void setSink(Sink sink);
+
+struct Argument {
+    static constexpr std::size_t MaxStringLength = 23;
+    /// LongString points to the caller's string and is only valid during the log call
+    enum class Type : std::uint8_t { Signed, Unsigned, Double, Pointer, String, LongString };
+
+    Type type;
+    union {
+        std::int64_t i;
+        std::uint64_t u;
+        double d;
+        const void* p;
+        char s[MaxStringLength + 1];
+    };
+};
+
+constexpr std::size_t MaxArguments = 8;
+
+namespace detail {
+    /// Copies the message into the calling thread's ring buffer
+    void push(Level level, const char* message, const Argument* arguments, std::size_t count);
+
+    /// Formats a stored message, this is what the background thread does with each message
+    std::string format(const char* message, const Argument* arguments, std::size_t count);
+
+    inline Argument makeArgument(const char* value) {
+        Argument a;
+        if (value == nullptr) {
+            value = "(null)";
+        }
+        const std::size_t length = std::strlen(value);
+        if (length > Argument::MaxStringLength) {
+            a.type = Argument::Type::LongString;
+            a.p = value;
+            return a;
+        }
+        a.type = Argument::Type::String;
+        std::memcpy(a.s, value, length + 1);
+        return a;
+    }
+
+    template <typename T>
+    Argument makeArgument(const T& value) {
+        Argument a;
+        if constexpr (std::is_floating_point_v<T>) {
+            a.type = Argument::Type::Double;
+            a.d = static_cast<double>(value);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            a.type = Argument::Type::Signed;
+            a.i = static_cast<std::int64_t>(value);
+        }
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            a.type = Argument::Type::Unsigned;
+            a.u = static_cast<std::uint64_t>(value);
+        }
+        else {
+            static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+            a.type = Argument::Type::Pointer;
+            a.p = static_cast<const void*>(value);
+        }
+        return a;
+    }
+} // namespace detail
+
+template <typename... Args>
+void log(Level level, const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= MaxArguments, "Too many log arguments");
+    if constexpr (sizeof...(Args) == 0) {
+        detail::push(level, format, nullptr, 0);
+    }
+    else {
+        const Argument arguments[] = { detail::makeArgument(args)... };
+        detail::push(level, format, arguments, sizeof...(Args));
+    }
+}
+
+} // namespace logging
+
+#ifndef PARTICLESYSTEM_LOG_LEVEL
+#ifdef NDEBUG
+#define PARTICLESYSTEM_LOG_LEVEL 1
+#else
+#define PARTICLESYSTEM_LOG_LEVEL 0
+#endif
+#endif
+
+#define PARTICLESYSTEM_LOG(level, ...)                                                      \
+    do {                                                                                    \
+        if (logging::isEnabled(level)) {                                                    \
+            logging::log(level, __VA_ARGS__);                                               \
+        }                                                                                   \
+    } while (false)
+
+#if PARTICLESYSTEM_LOG_LEVEL <= 0
+#define LOG_DEBUG(...) PARTICLESYSTEM_LOG(logging::Level::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (false)
+#endif
+
+#if PARTICLESYSTEM_LOG_LEVEL <= 1
+#define LOG_INFO(...) PARTICLESYSTEM_LOG(logging::Level::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (false)
+#endif
+
+#if PARTICLESYSTEM_LOG_LEVEL <= 2
+#define LOG_WARNING(...) PARTICLESYSTEM_LOG(logging::Level::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) do {} while (false)
+#endif
+
+#if PARTICLESYSTEM_LOG_LEVEL <= 3
+#define LOG_ERROR(...) PARTICLESYSTEM_LOG(logging::Level::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (false)
+#endif
+
+#endif // __LOG_H__
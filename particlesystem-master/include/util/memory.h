@@ -0,0 +1,80 @@
+#ifndef __MEMORY_H__
+#define __MEMORY_H__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/// Allocation of the large per-particle arrays. Small requests go through the regular
+/// operator new, requests of at least largeAllocationThreshold bytes are mapped directly
+/// from the operating system so that their page size and placement can be controlled.
+namespace memory {
+
+/// The two options exclude each other. A 2 MiB huge page holds the chunks of several
+/// owners and is placed on the node of whichever thread touches it first, so first touch
+/// is skipped while huge pages are enabled
+struct Policy {
+    /// Ask the kernel to back large arrays with huge pages. Explicit MAP_HUGETLB pages are
+    /// tried first and transparent huge pages (madvise) are used if none are reserved
+    bool hugePages = true;
+
+    /// Touch newly allocated pages from the worker threads so every page is placed on the
+    /// NUMA node of the thread that will process it. The array is split into chunks of
+    /// chunkSize elements and each chunk is touched by ThreadPool::chunkOwner, which does
+    /// not depend on how much of the capacity is in use. Only used without hugePages
+    bool numaFirstTouch = false;
+};
+
+constexpr std::size_t largeAllocationThreshold = std::size_t(2) << 20;
+
+/// The number of elements in each first-touch chunk. Parallel loops over large arrays
+/// should hand chunk c to ThreadPool::chunkOwner(c) to work on local memory
+constexpr std::size_t chunkSize = 16384;
+
+/// The size of the pages that first touch places, chunks of any element size start on a
+/// page boundary so that no page is shared by two owners
+std::size_t pageSize();
+
+void setPolicy(const Policy& policy);
+Policy getPolicy();
+
+/// Allocates \p bytes with the current policy, holding elements of \p elementSize bytes.
+/// Never returns nullptr, throws std::bad_alloc
+void* allocate(std::size_t bytes, std::size_t elementSize = 1);
+
+/// Releases memory from allocate, \p bytes has to be the same value that was allocated
+void deallocate(void* pointer, std::size_t bytes) noexcept;
+
+/// A std-compatible allocator that gets its memory from memory::allocate
+template <typename T>
+struct Allocator {
+    using value_type = T;
+
+    Allocator() noexcept = default;
+    template <typename U>
+    Allocator(const Allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::size_t(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(memory::allocate(n * sizeof(T), sizeof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t n) noexcept {
+        memory::deallocate(pointer, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const Allocator<T>&, const Allocator<U>&) noexcept { return true; }
+template <typename T, typename U>
+bool operator!=(const Allocator<T>&, const Allocator<U>&) noexcept { return false; }
+
+/// A vector whose storage is allocated with memory::Allocator
+template <typename T>
+using LargeVector = std::vector<T, Allocator<T>>;
+
+} // namespace memory
+
+#endif // __MEMORY_H__
@@ -0,0 +1,83 @@
+#ifndef __PERFSTATS_H__
+#define __PERFSTATS_H__
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/// Lightweight timing counters for the in-app performance panel. Phase timers only add to
+/// an atomic counter, the per-frame totals are moved into fixed size ring buffers once per
+/// frame by endFrame, so collecting the statistics costs next to nothing.
+namespace perf {
+
+enum class Phase {
+    Simulation,
+    Pack,
+    Upload,
+    Draw,
+    Count
+};
+
+const char* phaseName(Phase phase);
+
+/// Keeps the most recent \p capacity samples, the oldest sample is overwritten when full
+class SampleRing {
+public:
+    explicit SampleRing(std::size_t capacity = 512);
+
+    void push(float value);
+
+    std::size_t size() const;
+    std::size_t capacity() const;
+    /// The raw storage, the oldest sample is at offset() once the ring has wrapped around
+    const float* data() const;
+    std::size_t offset() const;
+
+    float latest() const;
+    float mean() const;
+    /// Returns the \p p-th percentile (0-100) of the stored samples, 0 if there are none
+    float percentile(float p) const;
+
+    /**
+     * Sorts the stored samples into \p binCount equally wide bins between 0 and
+     * \p maxValue, larger samples end up in the last bin.
+     */
+    void histogram(float* bins, int binCount, float maxValue) const;
+
+private:
+    std::vector<float> samples;
+    std::size_t next = 0;
+    std::size_t count = 0;
+    mutable std::vector<float> sorted;
+};
+
+/// Adds \p seconds to the current frame's total for \p phase. Safe to call from any thread
+void addTime(Phase phase, double seconds);
+
+/// Measures the lifetime of the object and adds it to a phase
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Phase inPhase);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+/// Closes the current frame and stores the frame time, phase totals and particle count
+void endFrame(float frameTime, std::size_t liveParticles);
+
+const SampleRing& frameTimes();
+const SampleRing& phaseTimes(Phase phase);
+const SampleRing& particleCounts();
+
+/// Draws the performance panel with the ui helpers, has to be called inside a ui::GuiScope
+void showPanel();
+
+} // namespace perf
+
+#endif // __PERFSTATS_H__
@@ -0,0 +1,127 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Contiguous storage for objects of a single type. The pool owns its objects by value, so
+ * iterating over them walks linear memory and they are destroyed together with the pool.
+ *
+ * Objects are referred to by the key returned from add, which stays valid for the lifetime
+ * of the object even if the pool grows or other objects are removed. A key is a slot index
+ * and a generation. Removing an object bumps the generation of its slot so that old keys
+ * can be detected, and the slot is reused by later adds. Lookup and removal are O(1), the
+ * removed object is replaced by the last one so the storage stays dense. Pointers and
+ * references to the objects are invalidated when objects are added or removed, and
+ * removal changes the iteration order.
+ */
+template <typename T>
+class Pool {
+public:
+    using Index = std::uint32_t;
+
+    struct Key {
+        Index index;
+        std::uint32_t generation;
+    };
+
+    /// Constructs a new object in place and returns its key
+    template <typename... Args>
+    Key add(Args&&... args) {
+        Index slot;
+        if (freeSlots.empty()) {
+            slot = static_cast<Index>(slots.size());
+            slots.push_back({ 0, 0 });
+        } else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        items.emplace_back(std::forward<Args>(args)...);
+        itemSlots.push_back(slot);
+        slots[slot].item = static_cast<Index>(items.size() - 1);
+        return { slot, slots[slot].generation };
+    }
+
+    /// Destroys the object referred to by \p key. Returns false if it was already removed
+    bool remove(Key key) {
+        if (!contains(key)) {
+            return false;
+        }
+        const Index item = slots[key.index].item;
+        if (item + 1 != items.size()) {
+            items[item] = std::move(items.back());
+            itemSlots[item] = itemSlots.back();
+            slots[itemSlots[item]].item = item;
+        }
+        items.pop_back();
+        itemSlots.pop_back();
+        slots[key.index].generation++;
+        freeSlots.push_back(key.index);
+        return true;
+    }
+
+    /// Whether \p key refers to an object that has not been removed
+    bool contains(Key key) const {
+        return key.index < slots.size() && slots[key.index].generation == key.generation;
+    }
+
+    T& operator[](Key key) {
+        assert(contains(key));
+        return items[slots[key.index].item];
+    }
+
+    const T& operator[](Key key) const {
+        assert(contains(key));
+        return items[slots[key.index].item];
+    }
+
+    /// The key of the object at \p position in the iteration order
+    Key keyAt(std::size_t position) const {
+        assert(position < items.size());
+        const Index slot = itemSlots[position];
+        return { slot, slots[slot].generation };
+    }
+
+    std::size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    void reserve(std::size_t capacity) {
+        items.reserve(capacity);
+        itemSlots.reserve(capacity);
+    }
+
+    /// Destroys all objects in the pool. Keys handed out before stay invalid, and the
+    /// following adds use the slots in order from 0 just like in a new pool
+    void clear() {
+        for (Index slot : itemSlots) {
+            slots[slot].generation++;
+        }
+        items.clear();
+        itemSlots.clear();
+        freeSlots.clear();
+        for (std::size_t slot = slots.size(); slot > 0; slot--) {
+            freeSlots.push_back(static_cast<Index>(slot - 1));
+        }
+    }
+
+    typename std::vector<T>::iterator begin() { return items.begin(); }
+    typename std::vector<T>::iterator end() { return items.end(); }
+    typename std::vector<T>::const_iterator begin() const { return items.begin(); }
+    typename std::vector<T>::const_iterator end() const { return items.end(); }
+
+private:
+    struct Slot {
+        Index item;
+        std::uint32_t generation;
+    };
+
+    std::vector<T> items;
+    // The slot of every object, needed to update the slot of the object moved by remove
+    std::vector<Index> itemSlots;
+    std::vector<Slot> slots;
+    std::vector<Index> freeSlots;
+};
+
+#endif // __POOL_H__
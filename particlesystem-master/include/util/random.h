@@ -0,0 +1,65 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// Counter-based random numbers. Every value is a pure function of a key and a counter, so
+/// values can be generated in any order, on any thread and in SIMD lanes, and the result
+/// is always the same.
+namespace rng {
+
+using Counter = std::array<std::uint32_t, 4>;
+using Key = std::array<std::uint32_t, 2>;
+
+/// The Philox4x32-10 generator by Salmon et al., maps a 128-bit counter and a 64-bit key
+/// to 128 random bits
+Counter philox(Counter counter, Key key);
+
+/// Converts 32 random bits to a float in [0, 1) using the upper 24 bits
+inline float toUnitFloat(std::uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * A reproducible random stream. Element \p index of the stream consists of four uniform
+ * numbers that only depend on the seed, the stream id (for example the id of an emitter),
+ * the purpose and the index, so splitting the generation of a stream over threads or SIMD
+ * lanes does not change its values.
+ */
+class Stream {
+public:
+    /// \param purpose Separates streams that share seed and id but are used for different things
+    explicit Stream(std::uint64_t seed = 0, std::uint32_t id = 0, std::uint32_t purpose = 0);
+
+    /// The four numbers of element \p index, each in [0, 1)
+    std::array<float, 4> uniform4(std::uint64_t index) const;
+
+    /**
+     * Writes the elements [\p firstIndex, \p firstIndex + \p count) of the stream, the k-th
+     * number of element firstIndex + i goes to out[k][i]. Uses SSE when available and
+     * generates four elements at a time.
+     *
+     * \pre Each of the four arrays in \p out has room for \p count values
+     */
+    void uniformBatch(std::uint64_t firstIndex, std::size_t count, float* const out[4]) const;
+
+    /**
+     * Writes the numbers [\p firstNumber, \p firstNumber + \p count) of the stream read as
+     * one sequence, where number n is number n % 4 of element n / 4. For users that need
+     * one value per item, so that all four numbers of an element are used.
+     *
+     * \pre \p out has room for \p count values
+     */
+    void uniformSequence(std::uint64_t firstNumber, std::size_t count, float* out) const;
+
+private:
+    Key key;
+    std::uint32_t id;
+    std::uint32_t purpose;
+};
+
+} // namespace rng
+
+#endif // __RANDOM_H__
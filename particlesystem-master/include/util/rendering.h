@@ -3,6 +3,10 @@
 
 #include "vec2.h"
 #include "color.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -62,9 +66,114 @@ struct ForceInfo {
     Color color = Color(0.8f, 0.2f, 1.f);
 };
 
+/**
+ * The geometry that is submitted to a fixed number of layers during one frame. This is the
+ * bookkeeping part of the Renderer and holds no GL objects, so it can be used without a
+ * window.
+ *
+ * The submit functions can be called concurrently from any thread, drain must not be
+ * called concurrently with them.
+ */
+class LayerQueue {
+public:
+    /// The number of layers that are available for submitting geometry
+    static constexpr int NumberOfLayers = 8;
+
+    /// Everything that was submitted to one layer, in the order in which it arrived
+    struct Layer {
+        std::vector<ParticleInfo> particles;
+        std::vector<EmitterInfo> emitters;
+        std::vector<ForceInfo> forces;
+    };
+
+    /**
+     * Appends a copy of the data to \p layer.
+     *
+     * \pre \p layer must be in the range [0, NumberOfLayers)
+     */
+    void submitParticles(int layer, const std::vector<ParticleInfo>& particles);
+    void submitEmitters(int layer, const std::vector<EmitterInfo>& emitters);
+    void submitForces(int layer, const std::vector<ForceInfo>& forces);
+
+    /**
+     * Calls \p function for every layer that holds any data, layer 0 first, and empties
+     * the layer afterwards. The vectors keep their memory for the next frame.
+     *
+     * \param function Called with the index of the layer and its contents
+     */
+    void drain(const std::function<void(int layer, const Layer& contents)>& function);
+
+private:
+    struct Slot {
+        std::mutex mutex;
+        Layer contents;
+    };
+    std::array<Slot, NumberOfLayers> slots;
+};
+
+/**
+ * A window together with the GL objects that are needed to draw particles, emitters, and
+ * forces. The geometry is submitted into a fixed number of layers, each with its own GPU
+ * buffers. All layers are uploaded and drawn in one batch when the frame ends, layer 0
+ * first, so that several independent particle systems can be drawn on top of each other
+ * without merging their data by hand.
+ *
+ * The submit functions can be called concurrently from any thread. All other functions
+ * must be called on the thread that created the renderer. The first renderer that is
+ * created also hosts the user interface.
+ */
+class Renderer {
+public:
+    /// The number of layers that are available for submitting geometry
+    static constexpr int NumberOfLayers = LayerQueue::NumberOfLayers;
+
+    /**
+     * Creates the rendering window and the GL objects for all layers.
+     *
+     * \param title The title of the window
+     * \throw std::runtime_error If there was a compilation error with a shader
+     */
+    explicit Renderer(const char* title = "Particle System");
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    /// Sets the background color, see rendering::setBackgroundColor
+    void setBackgroundColor(float r, float g, float b);
+
+    /// Starts a new frame, see rendering::beginFrame
+    [[ nodiscard ]] float beginFrame();
+
+    /**
+     * Adds geometry to \p layer for the current frame. The data is copied, so it can be
+     * reused by the caller right away. Submissions to the same layer from different
+     * threads are drawn in the order in which they arrive.
+     *
+     * \pre \p layer must be in the range [0, NumberOfLayers)
+     */
+    void submitParticles(int layer, const std::vector<ParticleInfo>& particles);
+    void submitEmitters(int layer, const std::vector<EmitterInfo>& emitters);
+    void submitForces(int layer, const std::vector<ForceInfo>& forces);
+
+    /// Uploads and draws everything that was submitted since the last flush and empties
+    /// all layers. Is called by endFrame, but can be called earlier to draw below the UI
+    void flush();
+
+    /// Draws all submitted layers and swaps the buffers, see rendering::endFrame
+    [[ nodiscard ]] bool endFrame();
+
+    /// The window and GL objects, only defined in rendering.cpp
+    struct State;
+
+private:
+    std::unique_ptr<State> state;
+};
+
 /**
  * This function creates the rendering window and initializes all the necessary background
- * state. This function must only be called once per application.
+ * state. This function must only be called once per application. The functions below
+ * forward to the Renderer that is created here, which can be accessed with getRenderer.
  *
  * \throw std::runtime_error If there was a compilation error with a shader
  * \pre This function has not been called before
@@ -80,6 +189,13 @@ void createWindow();
  */
 void destroyWindow();
 
+/**
+ * Returns the renderer that was created by createWindow.
+ *
+ * \pre The createWindow function has been called exactly once in the application
+ */
+Renderer& getRenderer();
+
 /**
  * Sets the background color that is used for clearing the window.
  *
@@ -104,7 +220,8 @@ void setBackgroundColor(float r, float g, float b);
 [[ nodiscard ]] float beginFrame();
 
 /**
- * Renders a list of particles.
+ * Renders a list of particles. They are submitted to layer 0 of the renderer and drawn
+ * when the frame ends.
  * 
  * \param particles The information about the particles that are rendered in the next call
  *        to the render function
@@ -114,7 +231,8 @@ void setBackgroundColor(float r, float g, float b);
 void renderParticles(const std::vector<ParticleInfo>& particles);
 
 /**
- * Renders list of emitters.
+ * Renders list of emitters. They are submitted to layer 0 of the renderer and drawn when
+ * the frame ends.
  *
  * \param emitters The information about the emitters that are rendered in the next call
  *        to the render function
@@ -124,7 +242,8 @@ void renderParticles(const std::vector<ParticleInfo>& particles);
 void renderEmitters(const std::vector<EmitterInfo>& emitters);
 
 /**
- * Renders list of forces.
+ * Renders list of forces. They are submitted to layer 0 of the renderer and drawn when the
+ * frame ends.
  *
  * \param forces The information about the forces that are rendered in the next call to
  *        the render function
@@ -235,6 +354,26 @@ bool button(const char* label);
 
 bool checkbox(const char* label, bool& value);
 
+/**
+* Draws \p count values as a line graph. \p offset is the index of the first value, which
+* allows drawing a ring buffer without reordering it.
+*
+* \pre \p label must not be a nullptr
+* \pre \p values must point to at least \p count values
+* \param minValue, maxValue The range of the vertical axis, if they are equal the range
+*        is computed from the values
+*/
+void plotLines(const char* label, const float* values, int count, int offset = 0,
+               float minValue = 0.f, float maxValue = 0.f);
+
+/**
+* Draws \p count values as a bar chart, for example the bins of a histogram.
+*
+* \pre \p label must not be a nullptr
+* \pre \p values must point to at least \p count values
+*/
+void plotHistogram(const char* label, const float* values, int count);
+
 /**
 * Creates a group with a specific name \p label.
 * Should be terminated with endGroup.
@@ -0,0 +1,36 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#include "vec2.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLESYSTEM_SSE
+#endif
+
+/// Small helpers shared by the SSE force kernels. All of them operate on arrays of
+/// interleaved vec2 values, four vectors at a time.
+namespace simd {
+
+#ifdef PARTICLESYSTEM_SSE
+
+/// Loads four interleaved vec2 values starting at \p v into one x and one y register
+inline void loadInterleaved(const vec2* v, __m128& x, __m128& y) {
+    const __m128 v01 = _mm_loadu_ps(&v[0].x);
+    const __m128 v23 = _mm_loadu_ps(&v[2].x);
+    x = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+    y = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+/// Adds the x and y registers lane-wise to the four interleaved vec2 values at \p v
+inline void addInterleaved(vec2* v, __m128 x, __m128 y) {
+    float* f = &v[0].x;
+    _mm_storeu_ps(f, _mm_add_ps(_mm_loadu_ps(f), _mm_unpacklo_ps(x, y)));
+    _mm_storeu_ps(f + 4, _mm_add_ps(_mm_loadu_ps(f + 4), _mm_unpackhi_ps(x, y)));
+}
+
+#endif // PARTICLESYSTEM_SSE
+
+} // namespace simd
+
+#endif // __SIMD_H__
@@ -0,0 +1,68 @@
+#ifndef __TASKGRAPH_H__
+#define __TASKGRAPH_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * A set of tasks with dependencies between them that is executed on a ThreadPool. A task
+ * starts as soon as all of the tasks it depends on have finished, so independent chains
+ * of tasks (for example the stages of different chunks of particles) move forward
+ * concurrently without a barrier between the stages. Every task is recorded as its own
+ * Tracy zone with the name of the task.
+ *
+ * The graph is built on one thread and can be executed any number of times. Ready tasks
+ * are picked last in, first out, so a thread that finishes a task usually continues with
+ * the task that depends on it while the data is still in its cache.
+ *
+ * A task can prefer a thread of the pool, for example the owner of the memory it works
+ * on. Threads pick their own tasks first, then tasks without a preference, and only take
+ * tasks that prefer another thread when there is nothing else to do.
+ */
+class TaskGraph {
+public:
+    using TaskId = std::uint32_t;
+
+    static constexpr unsigned AnyThread = ~0u;
+
+    /**
+     * Adds a task that runs \p function once all \p dependencies have finished.
+     *
+     * \param name The name of the Tracy zone, has to outlive the graph
+     * \pre All \p dependencies have been added to this graph before
+     */
+    TaskId add(const char* name, std::function<void()> function,
+               std::initializer_list<TaskId> dependencies = {});
+
+    /// Makes \p after wait for \p before. \pre Both tasks have been added, \p before < \p after
+    void addDependency(TaskId before, TaskId after);
+
+    /// Lets \p task run on thread \p threadIndex of the pool if possible. Indices beyond
+    /// the size of the pool wrap around
+    void setPreferredThread(TaskId task, unsigned threadIndex);
+
+    /// Runs all tasks on \p pool and blocks until every one of them has finished
+    void execute(ThreadPool& pool);
+
+    /// Removes all tasks
+    void clear();
+    std::size_t size() const;
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> function;
+        std::vector<TaskId> successors;
+        std::uint32_t numberOfDependencies = 0;
+        unsigned preferredThread = AnyThread;
+    };
+
+    std::vector<Task> tasks;
+};
+
+#endif // __TASKGRAPH_H__
@@ -0,0 +1,87 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that is used to split data-parallel loops over all cores.
+ * The thread that calls one of the run functions takes part in the work as thread 0, so a
+ * pool with N threads starts N - 1 additional threads.
+ *
+ * The pool executes one job at a time. If a job is submitted while another one is running
+ * (for example from a second thread or from inside a job), the new job is executed on the
+ * calling thread instead, so calls never deadlock.
+ */
+class ThreadPool {
+public:
+    /**
+     * \param numberOfThreads The total number of threads including the calling thread. A
+     *        value of 0 uses the number of hardware threads
+     */
+    explicit ThreadPool(unsigned numberOfThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// The number of threads that take part in a job, including the calling thread
+    unsigned getNumberOfThreads() const;
+
+    /**
+     * Calls \p function once on every thread of the pool with the index of that thread
+     * and blocks until all calls have returned.
+     */
+    void run(const std::function<void(unsigned threadIndex)>& function);
+
+    /**
+     * Splits the range [0, \p count) into chunks of \p grainSize elements that are handed
+     * out to the threads as they become free. \p function is called with the half-open
+     * range [first, last) of each chunk. Blocks until the whole range has been processed.
+     */
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t first, std::size_t last)>& function,
+                     std::size_t grainSize = 1024);
+
+    /**
+     * Splits the range [0, \p count) into one contiguous block per thread, so thread i
+     * always receives the i-th block. Loops that are run this way touch the same memory
+     * from the same thread every time, which keeps the data on that thread's NUMA node
+     * when it was first written with the same partitioning.
+     */
+    void parallelForStatic(std::size_t count,
+                           const std::function<void(std::size_t first, std::size_t last)>& function);
+
+    /// Returns the block [first, last) that thread \p threadIndex gets in parallelForStatic
+    static void staticBlock(std::size_t count, unsigned numberOfThreads, unsigned threadIndex,
+                            std::size_t& first, std::size_t& last);
+
+    /// The thread that owns chunk \p chunk of a large array. Chunks are dealt out round
+    /// robin, so the owner of an element only depends on its index and not on the size of
+    /// the array. See memory::chunkSize
+    static unsigned chunkOwner(std::size_t chunk, unsigned numberOfThreads);
+
+    /// The pool shared by the whole application
+    static ThreadPool& global();
+
+private:
+    void workerLoop(unsigned threadIndex);
+
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    const std::function<void(unsigned)>* job = nullptr;
+    std::uint64_t generation = 0;
+    unsigned pending = 0;
+    bool stopping = false;
+};
+
+#endif // __THREADPOOL_H__
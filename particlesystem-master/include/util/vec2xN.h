@@ -0,0 +1,482 @@
+#ifndef __VEC2XN_H__
+#define __VEC2XN_H__
+
+#include "simd.h"
+#include "vec2.h"
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLESYSTEM_AVX
+#endif
+#if defined(__AVX512F__)
+#define PARTICLESYSTEM_AVX512
+#endif
+
+/// Batch types for writing vectorised kernels without raw intrinsics. A floatxN<N> holds
+/// N floats and a vec2xN<N> holds N vectors as separate x and y lanes (SoA). Widths 4, 8
+/// and 16 map onto SSE, AVX and AVX-512 when the compiler targets them, every other
+/// combination uses a plain array that the compiler is free to vectorise.
+namespace simd {
+
+/// The result of comparing two floatxN, one flag per lane
+template <int N>
+struct maskxN {
+    bool lane[N];
+};
+
+template <int N>
+struct floatxN {
+    static constexpr int Width = N;
+    using Mask = maskxN<N>;
+
+    float lane[N];
+
+    floatxN() = default;
+    /// Sets all lanes to \p value
+    floatxN(float value) {
+        for (int i = 0; i < N; i++) lane[i] = value;
+    }
+
+    /// Loads N floats, \p p does not have to be aligned
+    static floatxN load(const float* p) {
+        floatxN r;
+        for (int i = 0; i < N; i++) r.lane[i] = p[i];
+        return r;
+    }
+
+    void store(float* p) const {
+        for (int i = 0; i < N; i++) p[i] = lane[i];
+    }
+
+    float operator[](int i) const { return lane[i]; }
+};
+
+#define PARTICLESYSTEM_FLOATXN_BINARY(op)                                        \
+    template <int N>                                                             \
+    inline floatxN<N> operator op(const floatxN<N>& a, const floatxN<N>& b) {    \
+        floatxN<N> r;                                                            \
+        for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] op b.lane[i];          \
+        return r;                                                                \
+    }
+PARTICLESYSTEM_FLOATXN_BINARY(+)
+PARTICLESYSTEM_FLOATXN_BINARY(-)
+PARTICLESYSTEM_FLOATXN_BINARY(*)
+PARTICLESYSTEM_FLOATXN_BINARY(/)
+#undef PARTICLESYSTEM_FLOATXN_BINARY
+
+#define PARTICLESYSTEM_FLOATXN_COMPARE(op)                                       \
+    template <int N>                                                             \
+    inline maskxN<N> operator op(const floatxN<N>& a, const floatxN<N>& b) {     \
+        maskxN<N> r;                                                             \
+        for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] op b.lane[i];          \
+        return r;                                                                \
+    }
+PARTICLESYSTEM_FLOATXN_COMPARE(<)
+PARTICLESYSTEM_FLOATXN_COMPARE(<=)
+PARTICLESYSTEM_FLOATXN_COMPARE(>)
+PARTICLESYSTEM_FLOATXN_COMPARE(>=)
+#undef PARTICLESYSTEM_FLOATXN_COMPARE
+
+template <int N>
+inline maskxN<N> operator&(const maskxN<N>& a, const maskxN<N>& b) {
+    maskxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] && b.lane[i];
+    return r;
+}
+
+template <int N>
+inline maskxN<N> operator|(const maskxN<N>& a, const maskxN<N>& b) {
+    maskxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] || b.lane[i];
+    return r;
+}
+
+template <int N>
+inline bool any(const maskxN<N>& m) {
+    bool r = false;
+    for (int i = 0; i < N; i++) r |= m.lane[i];
+    return r;
+}
+
+/// Picks \p a in the lanes where \p m is set and \p b in the others
+template <int N>
+inline floatxN<N> select(const maskxN<N>& m, const floatxN<N>& a, const floatxN<N>& b) {
+    floatxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = m.lane[i] ? a.lane[i] : b.lane[i];
+    return r;
+}
+
+template <int N>
+inline floatxN<N> min(const floatxN<N>& a, const floatxN<N>& b) {
+    floatxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] < b.lane[i] ? a.lane[i] : b.lane[i];
+    return r;
+}
+
+template <int N>
+inline floatxN<N> max(const floatxN<N>& a, const floatxN<N>& b) {
+    floatxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = a.lane[i] > b.lane[i] ? a.lane[i] : b.lane[i];
+    return r;
+}
+
+template <int N>
+inline floatxN<N> sqrt(const floatxN<N>& a) {
+    floatxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = std::sqrt(a.lane[i]);
+    return r;
+}
+
+/// 1 / sqrt(a) with about 22 bits of precision on the SIMD targets
+template <int N>
+inline floatxN<N> rsqrtFast(const floatxN<N>& a) {
+    floatxN<N> r;
+    for (int i = 0; i < N; i++) r.lane[i] = 1.0f / std::sqrt(a.lane[i]);
+    return r;
+}
+
+#ifdef PARTICLESYSTEM_SSE
+
+template <>
+struct maskxN<4> {
+    __m128 v;
+};
+
+template <>
+struct floatxN<4> {
+    static constexpr int Width = 4;
+    using Mask = maskxN<4>;
+
+    __m128 v;
+
+    floatxN() = default;
+    floatxN(__m128 inV) : v(inV) {}
+    floatxN(float value) : v(_mm_set1_ps(value)) {}
+
+    static floatxN load(const float* p) { return _mm_loadu_ps(p); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    float operator[](int i) const {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return lanes[i];
+    }
+};
+
+inline floatxN<4> operator+(const floatxN<4>& a, const floatxN<4>& b) { return _mm_add_ps(a.v, b.v); }
+inline floatxN<4> operator-(const floatxN<4>& a, const floatxN<4>& b) { return _mm_sub_ps(a.v, b.v); }
+inline floatxN<4> operator*(const floatxN<4>& a, const floatxN<4>& b) { return _mm_mul_ps(a.v, b.v); }
+inline floatxN<4> operator/(const floatxN<4>& a, const floatxN<4>& b) { return _mm_div_ps(a.v, b.v); }
+inline maskxN<4> operator<(const floatxN<4>& a, const floatxN<4>& b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline maskxN<4> operator<=(const floatxN<4>& a, const floatxN<4>& b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline maskxN<4> operator>(const floatxN<4>& a, const floatxN<4>& b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline maskxN<4> operator>=(const floatxN<4>& a, const floatxN<4>& b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline maskxN<4> operator&(const maskxN<4>& a, const maskxN<4>& b) { return { _mm_and_ps(a.v, b.v) }; }
+inline maskxN<4> operator|(const maskxN<4>& a, const maskxN<4>& b) { return { _mm_or_ps(a.v, b.v) }; }
+inline bool any(const maskxN<4>& m) { return _mm_movemask_ps(m.v) != 0; }
+inline floatxN<4> select(const maskxN<4>& m, const floatxN<4>& a, const floatxN<4>& b) {
+    return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v));
+}
+inline floatxN<4> min(const floatxN<4>& a, const floatxN<4>& b) { return _mm_min_ps(a.v, b.v); }
+inline floatxN<4> max(const floatxN<4>& a, const floatxN<4>& b) { return _mm_max_ps(a.v, b.v); }
+inline floatxN<4> sqrt(const floatxN<4>& a) { return _mm_sqrt_ps(a.v); }
+inline floatxN<4> rsqrtFast(const floatxN<4>& a) {
+    // rsqrtps gives ~12 bits, one Newton-Raphson step brings it to ~22 bits
+    const __m128 estimate = _mm_rsqrt_ps(a.v);
+    const __m128 correction = _mm_sub_ps(_mm_set1_ps(1.5f),
+        _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a.v), _mm_mul_ps(estimate, estimate)));
+    return _mm_mul_ps(estimate, correction);
+}
+
+#endif // PARTICLESYSTEM_SSE
+
+#ifdef PARTICLESYSTEM_AVX
+
+template <>
+struct maskxN<8> {
+    __m256 v;
+};
+
+template <>
+struct floatxN<8> {
+    static constexpr int Width = 8;
+    using Mask = maskxN<8>;
+
+    __m256 v;
+
+    floatxN() = default;
+    floatxN(__m256 inV) : v(inV) {}
+    floatxN(float value) : v(_mm256_set1_ps(value)) {}
+
+    static floatxN load(const float* p) { return _mm256_loadu_ps(p); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+    float operator[](int i) const {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, v);
+        return lanes[i];
+    }
+};
+
+inline floatxN<8> operator+(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_add_ps(a.v, b.v); }
+inline floatxN<8> operator-(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_sub_ps(a.v, b.v); }
+inline floatxN<8> operator*(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_mul_ps(a.v, b.v); }
+inline floatxN<8> operator/(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_div_ps(a.v, b.v); }
+inline maskxN<8> operator<(const floatxN<8>& a, const floatxN<8>& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline maskxN<8> operator<=(const floatxN<8>& a, const floatxN<8>& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline maskxN<8> operator>(const floatxN<8>& a, const floatxN<8>& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline maskxN<8> operator>=(const floatxN<8>& a, const floatxN<8>& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline maskxN<8> operator&(const maskxN<8>& a, const maskxN<8>& b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline maskxN<8> operator|(const maskxN<8>& a, const maskxN<8>& b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline bool any(const maskxN<8>& m) { return _mm256_movemask_ps(m.v) != 0; }
+inline floatxN<8> select(const maskxN<8>& m, const floatxN<8>& a, const floatxN<8>& b) {
+    return _mm256_blendv_ps(b.v, a.v, m.v);
+}
+inline floatxN<8> min(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_min_ps(a.v, b.v); }
+inline floatxN<8> max(const floatxN<8>& a, const floatxN<8>& b) { return _mm256_max_ps(a.v, b.v); }
+inline floatxN<8> sqrt(const floatxN<8>& a) { return _mm256_sqrt_ps(a.v); }
+inline floatxN<8> rsqrtFast(const floatxN<8>& a) {
+    const __m256 estimate = _mm256_rsqrt_ps(a.v);
+    const __m256 correction = _mm256_sub_ps(_mm256_set1_ps(1.5f),
+        _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), a.v), _mm256_mul_ps(estimate, estimate)));
+    return _mm256_mul_ps(estimate, correction);
+}
+
+#endif // PARTICLESYSTEM_AVX
+
+#ifdef PARTICLESYSTEM_AVX512
+
+template <>
+struct maskxN<16> {
+    __mmask16 v;
+};
+
+template <>
+struct floatxN<16> {
+    static constexpr int Width = 16;
+    using Mask = maskxN<16>;
+
+    __m512 v;
+
+    floatxN() = default;
+    floatxN(__m512 inV) : v(inV) {}
+    floatxN(float value) : v(_mm512_set1_ps(value)) {}
+
+    static floatxN load(const float* p) { return _mm512_loadu_ps(p); }
+    void store(float* p) const { _mm512_storeu_ps(p, v); }
+
+    float operator[](int i) const {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, v);
+        return lanes[i];
+    }
+};
+
+inline floatxN<16> operator+(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_add_ps(a.v, b.v); }
+inline floatxN<16> operator-(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_sub_ps(a.v, b.v); }
+inline floatxN<16> operator*(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_mul_ps(a.v, b.v); }
+inline floatxN<16> operator/(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_div_ps(a.v, b.v); }
+inline maskxN<16> operator<(const floatxN<16>& a, const floatxN<16>& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline maskxN<16> operator<=(const floatxN<16>& a, const floatxN<16>& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) }; }
+inline maskxN<16> operator>(const floatxN<16>& a, const floatxN<16>& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+inline maskxN<16> operator>=(const floatxN<16>& a, const floatxN<16>& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ) }; }
+inline maskxN<16> operator&(const maskxN<16>& a, const maskxN<16>& b) { return { static_cast<__mmask16>(a.v & b.v) }; }
+inline maskxN<16> operator|(const maskxN<16>& a, const maskxN<16>& b) { return { static_cast<__mmask16>(a.v | b.v) }; }
+inline bool any(const maskxN<16>& m) { return m.v != 0; }
+inline floatxN<16> select(const maskxN<16>& m, const floatxN<16>& a, const floatxN<16>& b) {
+    return _mm512_mask_blend_ps(m.v, b.v, a.v);
+}
+inline floatxN<16> min(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_min_ps(a.v, b.v); }
+inline floatxN<16> max(const floatxN<16>& a, const floatxN<16>& b) { return _mm512_max_ps(a.v, b.v); }
+inline floatxN<16> sqrt(const floatxN<16>& a) { return _mm512_sqrt_ps(a.v); }
+inline floatxN<16> rsqrtFast(const floatxN<16>& a) {
+    // rsqrt14 is already accurate to 14 bits, the Newton-Raphson step gives ~23 bits
+    const __m512 estimate = _mm512_rsqrt14_ps(a.v);
+    const __m512 correction = _mm512_sub_ps(_mm512_set1_ps(1.5f),
+        _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), a.v), _mm512_mul_ps(estimate, estimate)));
+    return _mm512_mul_ps(estimate, correction);
+}
+
+#endif // PARTICLESYSTEM_AVX512
+
+// Mixed operations with a scalar broadcast it to all lanes
+template <int N> inline floatxN<N> operator+(const floatxN<N>& a, float b) { return a + floatxN<N>(b); }
+template <int N> inline floatxN<N> operator-(const floatxN<N>& a, float b) { return a - floatxN<N>(b); }
+template <int N> inline floatxN<N> operator*(const floatxN<N>& a, float b) { return a * floatxN<N>(b); }
+template <int N> inline floatxN<N> operator/(const floatxN<N>& a, float b) { return a / floatxN<N>(b); }
+template <int N> inline floatxN<N> operator+(float a, const floatxN<N>& b) { return floatxN<N>(a) + b; }
+template <int N> inline floatxN<N> operator-(float a, const floatxN<N>& b) { return floatxN<N>(a) - b; }
+template <int N> inline floatxN<N> operator*(float a, const floatxN<N>& b) { return floatxN<N>(a) * b; }
+template <int N> inline floatxN<N> operator/(float a, const floatxN<N>& b) { return floatxN<N>(a) / b; }
+template <int N> inline floatxN<N> operator-(const floatxN<N>& a) { return floatxN<N>(0.0f) - a; }
+template <int N> inline floatxN<N>& operator+=(floatxN<N>& a, const floatxN<N>& b) { return a = a + b; }
+template <int N> inline floatxN<N>& operator*=(floatxN<N>& a, const floatxN<N>& b) { return a = a * b; }
+
+/// N vectors stored as one batch of x values and one batch of y values
+template <int N>
+struct vec2xN {
+    static constexpr int Width = N;
+
+    floatxN<N> x;
+    floatxN<N> y;
+
+    vec2xN() = default;
+    vec2xN(const floatxN<N>& inX, const floatxN<N>& inY) : x(inX), y(inY) {}
+    /// Sets all lanes to \p v
+    explicit vec2xN(vec2 v) : x(v.x), y(v.y) {}
+
+    /// Loads N consecutive vec2, for example a column of particle positions
+    static vec2xN load(const vec2* v);
+    /// Stores the lanes as N consecutive vec2
+    void store(vec2* v) const;
+    /// Adds the lanes to N consecutive vec2, the common way kernels write their results
+    void addTo(vec2* v) const;
+
+    /// Loads N values from separate x and y arrays
+    static vec2xN load(const float* xs, const float* ys) {
+        return { floatxN<N>::load(xs), floatxN<N>::load(ys) };
+    }
+
+    vec2 operator[](int i) const { return vec2(x[i], y[i]); }
+
+    vec2xN operator+(const vec2xN& rhs) const { return { x + rhs.x, y + rhs.y }; }
+    vec2xN operator-(const vec2xN& rhs) const { return { x - rhs.x, y - rhs.y }; }
+    vec2xN operator*(const vec2xN& rhs) const { return { x * rhs.x, y * rhs.y }; }
+    vec2xN operator/(const vec2xN& rhs) const { return { x / rhs.x, y / rhs.y }; }
+    /// Scales every vector by its own lane of \p rhs
+    vec2xN operator*(const floatxN<N>& rhs) const { return { x * rhs, y * rhs }; }
+    vec2xN operator/(const floatxN<N>& rhs) const { return { x / rhs, y / rhs }; }
+    vec2xN operator*(float rhs) const { return { x * rhs, y * rhs }; }
+    vec2xN operator/(float rhs) const { return { x / rhs, y / rhs }; }
+    vec2xN& operator+=(const vec2xN& rhs) { return *this = *this + rhs; }
+    vec2xN& operator-=(const vec2xN& rhs) { return *this = *this - rhs; }
+
+    floatxN<N> lengthSquared() const { return x * x + y * y; }
+    floatxN<N> length() const { return sqrt(lengthSquared()); }
+    vec2xN normalized() const { return *this / length(); }
+    /// Uses the approximate reciprocal square root, see rsqrtFast
+    vec2xN normalizedFast() const { return *this * rsqrtFast(lengthSquared()); }
+};
+
+template <int N>
+inline floatxN<N> dot(const vec2xN<N>& a, const vec2xN<N>& b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+template <int N>
+inline vec2xN<N> select(const maskxN<N>& m, const vec2xN<N>& a, const vec2xN<N>& b) {
+    return { select(m, a.x, b.x), select(m, a.y, b.y) };
+}
+
+template <int N>
+inline vec2xN<N> vec2xN<N>::load(const vec2* v) {
+    vec2xN r;
+    float xs[N], ys[N];
+    for (int i = 0; i < N; i++) {
+        xs[i] = v[i].x;
+        ys[i] = v[i].y;
+    }
+    r.x = floatxN<N>::load(xs);
+    r.y = floatxN<N>::load(ys);
+    return r;
+}
+
+template <int N>
+inline void vec2xN<N>::store(vec2* v) const {
+    float xs[N], ys[N];
+    x.store(xs);
+    y.store(ys);
+    for (int i = 0; i < N; i++) {
+        v[i] = vec2(xs[i], ys[i]);
+    }
+}
+
+template <int N>
+inline void vec2xN<N>::addTo(vec2* v) const {
+    (load(v) + *this).store(v);
+}
+
+#ifdef PARTICLESYSTEM_SSE
+
+template <>
+inline vec2xN<4> vec2xN<4>::load(const vec2* v) {
+    vec2xN r;
+    loadInterleaved(v, r.x.v, r.y.v);
+    return r;
+}
+
+template <>
+inline void vec2xN<4>::store(vec2* v) const {
+    float* f = &v[0].x;
+    _mm_storeu_ps(f, _mm_unpacklo_ps(x.v, y.v));
+    _mm_storeu_ps(f + 4, _mm_unpackhi_ps(x.v, y.v));
+}
+
+template <>
+inline void vec2xN<4>::addTo(vec2* v) const {
+    addInterleaved(v, x.v, y.v);
+}
+
+#endif // PARTICLESYSTEM_SSE
+
+#ifdef PARTICLESYSTEM_AVX
+
+template <>
+inline vec2xN<8> vec2xN<8>::load(const vec2* v) {
+    // a = v0 v1 | v2 v3 and b = v4 v5 | v6 v7, regroup the halves before deinterleaving
+    const __m256 a = _mm256_loadu_ps(&v[0].x);
+    const __m256 b = _mm256_loadu_ps(&v[4].x);
+    const __m256 low = _mm256_permute2f128_ps(a, b, 0x20);
+    const __m256 high = _mm256_permute2f128_ps(a, b, 0x31);
+    return { _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)),
+             _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)) };
+}
+
+template <>
+inline void vec2xN<8>::store(vec2* v) const {
+    const __m256 low = _mm256_unpacklo_ps(x.v, y.v);
+    const __m256 high = _mm256_unpackhi_ps(x.v, y.v);
+    _mm256_storeu_ps(&v[0].x, _mm256_permute2f128_ps(low, high, 0x20));
+    _mm256_storeu_ps(&v[4].x, _mm256_permute2f128_ps(low, high, 0x31));
+}
+
+#endif // PARTICLESYSTEM_AVX
+
+#ifdef PARTICLESYSTEM_AVX512
+
+template <>
+inline vec2xN<16> vec2xN<16>::load(const vec2* v) {
+    const __m512 a = _mm512_loadu_ps(&v[0].x);
+    const __m512 b = _mm512_loadu_ps(&v[8].x);
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    return { _mm512_permutex2var_ps(a, even, b), _mm512_permutex2var_ps(a, odd, b) };
+}
+
+template <>
+inline void vec2xN<16>::store(vec2* v) const {
+    const __m512i low = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i high = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    _mm512_storeu_ps(&v[0].x, _mm512_permutex2var_ps(x.v, low, y.v));
+    _mm512_storeu_ps(&v[8].x, _mm512_permutex2var_ps(x.v, high, y.v));
+}
+
+#endif // PARTICLESYSTEM_AVX512
+
+/// The widest batch that the compiler targets natively
+#if defined(PARTICLESYSTEM_AVX512)
+constexpr int NativeWidth = 16;
+#elif defined(PARTICLESYSTEM_AVX)
+constexpr int NativeWidth = 8;
+#else
+constexpr int NativeWidth = 4;
+#endif
+
+using floatv = floatxN<NativeWidth>;
+using vec2v = vec2xN<NativeWidth>;
+
+} // namespace simd
+
+#endif // __VEC2XN_H__
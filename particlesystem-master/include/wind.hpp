@@ -18,12 +18,15 @@
 
 class Wind: public Force {
     public:
-        Wind(vec2 inPosition, float inSize, Color inColor, float inAngle);
+        Wind(vec2 inPosition, float inSize, Color inColor, float inAngle, float inRadius = 0.0f);
         vec2 computeForce(vec2 particlePosition);
+        void accumulateForces(const vec2* positions, vec2* forces, std::size_t count);
         //void changeAngle(float newAngle);
     private:
     float angle;
     float windPower;
+    vec2 direction;            //Enhetsvektor i vindens riktning
+    float cosSpreadSquared;    //cos^2 av halva konens öppningsvinkel
 };
 
 #endif /* wind_hpp */
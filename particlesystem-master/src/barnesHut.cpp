@@ -0,0 +1,186 @@
+//
+//  barnesHut.cpp
+//  ParticleSystem
+//
+
+#include "barnesHut.hpp"
+
+#include "Tracy.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr int MaxLevel = 16;            //16 bitar per axel i mortonkoden
+    constexpr std::uint32_t LeafSize = 8;   //Så här få partiklar eller färre blir ett löv
+
+    //Sprider ut de 16 låga bitarna så att det blir en nolla mellan varje bit
+    std::uint32_t spreadBits(std::uint32_t v) {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+} // namespace
+
+void BarnesHutTree::setOpeningAngle(float theta){
+    openingAngleSquared = theta*theta;
+}
+
+float BarnesHutTree::getOpeningAngle() const{
+    return std::sqrt(openingAngleSquared);
+}
+
+void BarnesHutTree::setGravitationalConstant(float G){
+    gravitationalConstant = G;
+}
+
+void BarnesHutTree::setSoftening(float inSoftening){
+    softeningSquared = inSoftening*inSoftening;
+}
+
+std::size_t BarnesHutTree::getNumberOfNodes() const{
+    return nodes.size();
+}
+
+void BarnesHutTree::build(const vec2* positions, const float* masses, std::size_t count){
+    ZoneScoped
+    nodes.clear();
+    if(count == 0){
+        return;
+    }
+
+    //Kvadratisk omslutande låda runt alla partiklar
+    vec2 minCorner = positions[0];
+    vec2 maxCorner = positions[0];
+    for(std::size_t i = 1; i < count; i++){
+        minCorner.x = std::min(minCorner.x, positions[i].x);
+        minCorner.y = std::min(minCorner.y, positions[i].y);
+        maxCorner.x = std::max(maxCorner.x, positions[i].x);
+        maxCorner.y = std::max(maxCorner.y, positions[i].y);
+    }
+    const float width = std::max(std::max(maxCorner.x - minCorner.x, maxCorner.y - minCorner.y), 1e-6f);
+    const float scale = 65535.0f/width;
+
+    //Sortera partiklarna längs mortonkurvan
+    keys.resize(count);
+    for(std::size_t i = 0; i < count; i++){
+        const std::uint32_t ix = static_cast<std::uint32_t>((positions[i].x - minCorner.x)*scale);
+        const std::uint32_t iy = static_cast<std::uint32_t>((positions[i].y - minCorner.y)*scale);
+        const std::uint64_t code = spreadBits(ix) | (spreadBits(iy) << 1);
+        keys[i] = (code << 32) | i;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    codes.resize(count);
+    order.resize(count);
+    sortedPositions.resize(count);
+    sortedMasses.resize(count);
+    for(std::size_t i = 0; i < count; i++){
+        codes[i] = static_cast<std::uint32_t>(keys[i] >> 32);
+        order[i] = static_cast<std::uint32_t>(keys[i] & 0xffffffff);
+        sortedPositions[i] = positions[order[i]];
+        sortedMasses[i] = masses[order[i]];
+    }
+
+    nodes.reserve(2*count/LeafSize + 1);
+    buildNode(0, static_cast<std::uint32_t>(count), 0, width);
+}
+
+std::uint32_t BarnesHutTree::buildNode(std::uint32_t begin, std::uint32_t end, int level, float width){
+    const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    float mass = 0.0f;
+    vec2 weighted = {0.0f, 0.0f};
+    const bool leaf = end - begin <= LeafSize || level == MaxLevel;
+    if(leaf){
+        for(std::uint32_t i = begin; i < end; i++){
+            mass += sortedMasses[i];
+            weighted += sortedPositions[i]*sortedMasses[i];
+        }
+    }
+    else{
+        //Barnen är de fyra delintervallen som delar nästa två bitar i mortonkoden
+        const int shift = 2*(MaxLevel - 1 - level);
+        std::uint32_t childBegin = begin;
+        for(std::uint32_t quadrant = 0; quadrant < 4; quadrant++){
+            const std::uint32_t* childEnd = std::partition_point(
+                codes.data() + childBegin, codes.data() + end,
+                [shift, quadrant](std::uint32_t code){ return ((code >> shift) & 3) <= quadrant; });
+            const std::uint32_t childEndIndex = static_cast<std::uint32_t>(childEnd - codes.data());
+            if(childEndIndex > childBegin){
+                const std::uint32_t child = buildNode(childBegin, childEndIndex, level + 1, width*0.5f);
+                mass += nodes[child].mass;
+                weighted += nodes[child].centerOfMass*nodes[child].mass;
+            }
+            childBegin = childEndIndex;
+        }
+    }
+
+    Node& node = nodes[index];
+    node.leaf = leaf;
+    node.mass = mass;
+    node.centerOfMass = mass > 0.0f ? weighted/mass : sortedPositions[begin];
+    node.widthSquared = width*width;
+    node.firstParticle = begin;
+    node.numberOfParticles = end - begin;
+    node.next = static_cast<std::uint32_t>(nodes.size());
+    return index;
+}
+
+vec2 BarnesHutTree::computeForce(std::uint32_t particle) const{
+    const vec2 position = sortedPositions[particle];
+    vec2 sum = {0.0f, 0.0f};
+
+    std::uint32_t i = 0;
+    const std::uint32_t numberOfNodes = static_cast<std::uint32_t>(nodes.size());
+    while(i < numberOfNodes){
+        const Node& node = nodes[i];
+        const vec2 dist = node.centerOfMass - position;
+        const float distSquared = dist.x*dist.x + dist.y*dist.y;
+
+        //Noder som innehåller partikeln själv öppnas alltid, annars drar den i sig själv
+        //via tyngdpunkten när vinkeln är stor
+        const bool containsParticle = particle - node.firstParticle < node.numberOfParticles;
+        if(!node.leaf && (containsParticle || node.widthSquared >= openingAngleSquared*distSquared)){
+            //För nära för att approximeras, gå ner till första barnet
+            i++;
+            continue;
+        }
+
+        if(node.leaf){
+            for(std::uint32_t j = node.firstParticle; j < node.firstParticle + node.numberOfParticles; j++){
+                if(j == particle){
+                    continue;
+                }
+                const vec2 d = sortedPositions[j] - position;
+                const float r2 = std::max(d.x*d.x + d.y*d.y + softeningSquared, 1e-12f);
+                const float inverseDist = 1.0f/std::sqrt(r2);
+                sum += d*(sortedMasses[j]*inverseDist*inverseDist*inverseDist);
+            }
+        }
+        else{
+            const float r2 = distSquared + softeningSquared;
+            const float inverseDist = 1.0f/std::sqrt(r2);
+            sum += dist*(node.mass*inverseDist*inverseDist*inverseDist);
+        }
+        i = node.next;
+    }
+    return sum*(gravitationalConstant*sortedMasses[particle]);
+}
+
+void BarnesHutTree::accumulate(vec2* forces, ThreadPool& pool) const{
+    ZoneScoped
+    if(nodes.empty()){
+        return;
+    }
+
+    //Partiklar som ligger nära varandra på kurvan går igenom nästan samma noder
+    pool.parallelFor(order.size(), [&](std::size_t first, std::size_t last){
+        for(std::size_t k = first; k < last; k++){
+            forces[order[k]] += computeForce(static_cast<std::uint32_t>(k));
+        }
+    }, 256);
+}
@@ -6,11 +6,15 @@
 //
 
 #include "directional.hpp"
+#include <algorithm>
 
-std::vector<Particle> Directional::createParticles(float numberOfSpawnDirections, float inAngle){
-    std::vector<Particle> createdParticles;
-    float radius = 3.0f; //Ev flytta ut, så att access finns utifrån
+ParticleArchetype Directional::getParticleArchetype() const{
+    float radius = 3.0f;
     float mass = 0.15f;
+    return {radius, color, 1.0f/mass, 60.0f};
+}
+
+void Directional::emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle){
     angle = inAngle;
     
     //float theta = M_PI/4; //Vinkel som partiklarna skickas ut med
@@ -18,11 +22,11 @@ std::vector<Particle> Directional::createParticles(float numberOfSpawnDirections
     float x,y;
     x = magnitude*cos(angle);
     y = magnitude*sin(angle);
-    //Skapa en partikel
-    Particle newParticle = Particle(position, radius, color, mass, {x,y});
-    
-    //Lägga till partikel till createdParticles
-    createdParticles.push_back(newParticle); //bäst att använda push_back eller back_inserter?
-    
-    return createdParticles;
+    //Alla partiklar i utdata får samma riktning. De sprids ut längs sträckan de hinner under
+    //steget, annars hamnar de ovanpå varandra. Livslängden är densamma så antalet ändras inte
+    const vec2 velocity = {x,y};
+    for(int k = 0; k < particlesPerUpdate; k++){
+        const vec2 offset = velocity*(timestep*k/particlesPerUpdate);
+        out[k] = Particle(position + offset, velocity, archetype, particleLifetime);
+    }
 };
@@ -6,6 +6,8 @@
 //
 
 #include "emitter.h"
+#include <algorithm>
+#include <cmath>
 
 Emitter::Emitter(vec2 inPosition, float inSize, Color inColor){
     //emitterType = "uniform";
@@ -18,7 +20,94 @@ Emitter::Emitter(vec2 inPosition, float inSize, Color inColor){
     emitterType = type;
 };*/
 
-rendering::EmitterInfo Emitter::toEmitterInfo(){
+void Emitter::setArchetype(std::uint32_t inArchetype, const ParticleArchetype& inDescription){
+    archetype = inArchetype;
+    particleLifetime = inDescription.lifetime;
+}
+
+std::uint32_t Emitter::getArchetype() const{
+    return archetype;
+}
+
+void Emitter::setSpawnRate(int inParticlesPerUpdate){
+    particlesPerUpdate = std::max(inParticlesPerUpdate, 1);
+}
+
+void Emitter::setTimestep(float dt){
+    timestep = dt;
+}
+
+int Emitter::getSpawnRate() const{
+    return particlesPerUpdate;
+}
+
+std::size_t Emitter::getSpawnCount() const{
+    return static_cast<std::size_t>(particlesPerUpdate);
+}
+
+void Emitter::emit(Particle* out, float numberOfSpawnDirections, float inAngle){
+    const std::size_t count = getSpawnCount();
+    emitParticles(out, numberOfSpawnDirections, inAngle);
+    if(jitter.isActive()){
+        applyJitter(out, count);
+    }
+}
+
+std::vector<Particle> Emitter::createParticles(float numberOfSpawnDirections, float inAngle){
+    std::vector<Particle> createdParticles(getSpawnCount(), Particle(position, {0.0f, 0.0f}, archetype, particleLifetime));
+    emit(createdParticles.data(), numberOfSpawnDirections, inAngle);
+    return createdParticles;
+}
+
+void Emitter::setJitter(const EmitterJitter& inJitter, const rng::Stream& inStream,
+                        std::vector<std::uint32_t> inColorVariants){
+    jitter = inJitter;
+    stream = inStream;
+    colorVariants = std::move(inColorVariants);
+    numberOfEmitted = 0;
+}
+
+const EmitterJitter& Emitter::getJitter() const{
+    return jitter;
+}
+
+const std::vector<std::uint32_t>& Emitter::getColorVariants() const{
+    return colorVariants;
+}
+
+void Emitter::setColorVariants(std::vector<std::uint32_t> inColorVariants){
+    colorVariants = std::move(inColorVariants);
+}
+
+void Emitter::applyJitter(Particle* out, std::size_t count){
+    //Fyra slumptal per partikel: vinkel, fart, livstid och färg
+    randomScratch.resize(4 * count);
+    float* const random[4] = {randomScratch.data(), randomScratch.data() + count,
+                              randomScratch.data() + 2 * count, randomScratch.data() + 3 * count};
+    stream.uniformBatch(numberOfEmitted, count, random);
+    numberOfEmitted += count;
+
+    for(std::size_t i = 0; i < count; i++){
+        //Från [0, 1) till [-1, 1)
+        const float angleOffset = jitter.angle * (2.0f * random[0][i] - 1.0f);
+        const float speedScale = 1.0f + jitter.speed * (2.0f * random[1][i] - 1.0f);
+        const float lifetimeScale = 1.0f + jitter.lifetime * (2.0f * random[2][i] - 1.0f);
+
+        const vec2 v = out[i].getVelocity();
+        const float c = std::cos(angleOffset) * speedScale;
+        const float s = std::sin(angleOffset) * speedScale;
+        const vec2 velocity = {v.x * c - v.y * s, v.x * s + v.y * c};
+
+        std::uint32_t particleArchetype = out[i].getArchetype();
+        if(!colorVariants.empty()){
+            const std::size_t variant = static_cast<std::size_t>(random[3][i] * colorVariants.size());
+            particleArchetype = colorVariants[std::min(variant, colorVariants.size() - 1)];
+        }
+        out[i] = Particle(out[i].getPosition(), velocity, particleArchetype, out[i].getLifeTime() * lifetimeScale);
+    }
+}
+
+rendering::EmitterInfo Emitter::toEmitterInfo() const{
     rendering::EmitterInfo emitterInfo;
     emitterInfo.position = position;
     emitterInfo.size = size;
@@ -10,17 +10,19 @@
 //namespace {
 //} // namespace
 
-Force::Force(vec2 inPosition, float inSize, Color inColor){
+Force::Force(vec2 inPosition, float inSize, Color inColor, float inRadius){
     position = inPosition;
     size = inSize;
     color = inColor;
+    influenceRadius = inRadius;
+    inverseRadiusSquared = inRadius > 0.0f ? 1.0f/(inRadius*inRadius) : 0.0f;
 }
 
 /*void Force::changeForceType(std::string type) {
     forceType = type;
 }*/
 
-rendering::ForceInfo Force::toForceInfo(){
+rendering::ForceInfo Force::toForceInfo() const{
     rendering::ForceInfo forceInfo;
     forceInfo.position = position;
     forceInfo.size = size;
@@ -28,4 +30,22 @@ rendering::ForceInfo Force::toForceInfo(){
     return forceInfo;
 };
 
+vec2 Force::getPosition() const{
+    return position;
+}
+
+float Force::getInfluenceRadius() const{
+    return influenceRadius;
+}
+
+bool Force::isGlobal() const{
+    return influenceRadius <= 0.0f;
+}
+
+void Force::accumulateForces(const vec2* positions, vec2* forces, std::size_t count){
+    for(std::size_t i = 0; i < count; i++){
+        forces[i] += computeForce(positions[i]);
+    }
+}
+
 
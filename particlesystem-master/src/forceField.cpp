@@ -0,0 +1,152 @@
+//
+//  forceField.cpp
+//  ParticleSystem
+//
+
+#include "forceField.hpp"
+
+#include "util/simd.h"
+#include "Tracy.hpp"
+#include <algorithm>
+#include <cassert>
+
+ForceField::ForceField(int inResolution, vec2 inDomainMin, vec2 inDomainMax){
+    domainMin = inDomainMin;
+    domainMax = inDomainMax;
+    setResolution(inResolution);
+}
+
+void ForceField::setResolution(int inResolution){
+    assert(inResolution >= 2);
+    resolution = inResolution;
+    const vec2 cellSize = (domainMax - domainMin) / static_cast<float>(resolution - 1);
+    inverseCellSize = vec2(1.0f / cellSize.x, 1.0f / cellSize.y);
+    dirty = true;
+}
+
+int ForceField::getResolution() const{
+    return resolution;
+}
+
+void ForceField::markDirty(){
+    dirty = true;
+}
+
+bool ForceField::isDirty() const{
+    return dirty;
+}
+
+void ForceField::bake(const std::vector<Force*>& forces){
+    ZoneScoped
+
+    nodes.assign(static_cast<std::size_t>(resolution) * resolution, vec2(0.0f, 0.0f));
+    const vec2 cellSize = (domainMax - domainMin) / static_cast<float>(resolution - 1);
+
+    for(int j = 0; j < resolution; j++){
+        for(int i = 0; i < resolution; i++){
+            const vec2 nodePosition = domainMin + vec2(i * cellSize.x, j * cellSize.y);
+            vec2 sum = {0.0f, 0.0f};
+            for(Force* f: forces){
+                const vec2 force = f->computeForce(nodePosition);
+                //En nod precis på en kraftkälla ger inf/NaN, hoppa över den
+                if(std::isfinite(force.x) && std::isfinite(force.y)){
+                    sum += force;
+                }
+            }
+            nodes[static_cast<std::size_t>(j) * resolution + i] = sum;
+        }
+    }
+    dirty = false;
+}
+
+vec2 ForceField::sample(vec2 position) const{
+    assert(!dirty);
+
+    const float maxCoord = static_cast<float>(resolution - 1);
+    const float gx = std::clamp((position.x - domainMin.x) * inverseCellSize.x, 0.0f, maxCoord);
+    const float gy = std::clamp((position.y - domainMin.y) * inverseCellSize.y, 0.0f, maxCoord);
+    const int ix = std::min(static_cast<int>(gx), resolution - 2);
+    const int iy = std::min(static_cast<int>(gy), resolution - 2);
+    const float fx = gx - ix;
+    const float fy = gy - iy;
+
+    const vec2* row = nodes.data() + static_cast<std::size_t>(iy) * resolution + ix;
+    const vec2 bottom = row[0] + (row[1] - row[0]) * fx;
+    const vec2 top = row[resolution] + (row[resolution + 1] - row[resolution]) * fx;
+    return bottom + (top - bottom) * fy;
+}
+
+void ForceField::accumulate(const vec2* positions, vec2* forces, std::size_t count) const{
+    ZoneScoped
+    assert(!dirty);
+
+    std::size_t i = 0;
+#ifdef PARTICLESYSTEM_SSE
+    const __m128 minX = _mm_set1_ps(domainMin.x);
+    const __m128 minY = _mm_set1_ps(domainMin.y);
+    const __m128 invX = _mm_set1_ps(inverseCellSize.x);
+    const __m128 invY = _mm_set1_ps(inverseCellSize.y);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxCoord = _mm_set1_ps(static_cast<float>(resolution - 1));
+    const __m128i maxIndex = _mm_set1_epi32(resolution - 2);
+    const __m128i stride = _mm_set1_epi32(resolution);
+
+    for(; i + 4 <= count; i += 4){
+        __m128 px, py;
+        simd::loadInterleaved(positions + i, px, py);
+
+        const __m128 gx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(px, minX), invX), zero), maxCoord);
+        const __m128 gy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(py, minY), invY), zero), maxCoord);
+
+        //gx och gy är icke-negativa så trunkering är samma sak som floor
+        __m128i ix = _mm_cvttps_epi32(gx);
+        __m128i iy = _mm_cvttps_epi32(gy);
+        ix = _mm_sub_epi32(ix, _mm_and_si128(_mm_cmpgt_epi32(ix, maxIndex), _mm_sub_epi32(ix, maxIndex)));
+        iy = _mm_sub_epi32(iy, _mm_and_si128(_mm_cmpgt_epi32(iy, maxIndex), _mm_sub_epi32(iy, maxIndex)));
+        const __m128 fx = _mm_sub_ps(gx, _mm_cvtepi32_ps(ix));
+        const __m128 fy = _mm_sub_ps(gy, _mm_cvtepi32_ps(iy));
+
+        //Radindex * bredd, SSE2 saknar 32-bitars mullo så det görs via två 64-bitars mul
+        const __m128i rowEven = _mm_mul_epu32(iy, stride);
+        const __m128i rowOdd = _mm_mul_epu32(_mm_srli_si128(iy, 4), stride);
+        const __m128i row = _mm_unpacklo_epi32(
+            _mm_shuffle_epi32(rowEven, _MM_SHUFFLE(0, 0, 2, 0)),
+            _mm_shuffle_epi32(rowOdd, _MM_SHUFFLE(0, 0, 2, 0)));
+        alignas(16) int index[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_add_epi32(row, ix));
+
+        //Hämta de fyra hörnen för varje partikel
+        alignas(16) float c00x[4], c00y[4], c10x[4], c10y[4];
+        alignas(16) float c01x[4], c01y[4], c11x[4], c11y[4];
+        for(int lane = 0; lane < 4; lane++){
+            const vec2* node = nodes.data() + index[lane];
+            c00x[lane] = node[0].x;
+            c00y[lane] = node[0].y;
+            c10x[lane] = node[1].x;
+            c10y[lane] = node[1].y;
+            c01x[lane] = node[resolution].x;
+            c01y[lane] = node[resolution].y;
+            c11x[lane] = node[resolution + 1].x;
+            c11y[lane] = node[resolution + 1].y;
+        }
+
+        const __m128 a00x = _mm_load_ps(c00x), a00y = _mm_load_ps(c00y);
+        const __m128 a10x = _mm_load_ps(c10x), a10y = _mm_load_ps(c10y);
+        const __m128 a01x = _mm_load_ps(c01x), a01y = _mm_load_ps(c01y);
+        const __m128 a11x = _mm_load_ps(c11x), a11y = _mm_load_ps(c11y);
+
+        const __m128 bottomX = _mm_add_ps(a00x, _mm_mul_ps(_mm_sub_ps(a10x, a00x), fx));
+        const __m128 bottomY = _mm_add_ps(a00y, _mm_mul_ps(_mm_sub_ps(a10y, a00y), fx));
+        const __m128 topX = _mm_add_ps(a01x, _mm_mul_ps(_mm_sub_ps(a11x, a01x), fx));
+        const __m128 topY = _mm_add_ps(a01y, _mm_mul_ps(_mm_sub_ps(a11y, a01y), fx));
+        const __m128 resultX = _mm_add_ps(bottomX, _mm_mul_ps(_mm_sub_ps(topX, bottomX), fy));
+        const __m128 resultY = _mm_add_ps(bottomY, _mm_mul_ps(_mm_sub_ps(topY, bottomY), fy));
+
+        simd::addInterleaved(forces + i, resultX, resultY);
+    }
+#endif // PARTICLESYSTEM_SSE
+
+    for(; i < count; i++){
+        forces[i] += sample(positions[i]);
+    }
+}
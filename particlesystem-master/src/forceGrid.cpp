@@ -0,0 +1,152 @@
+//
+//  forceGrid.cpp
+//  ParticleSystem
+//
+
+#include "forceGrid.hpp"
+
+#include "Tracy.hpp"
+#include <algorithm>
+#include <cassert>
+
+ForceGrid::ForceGrid(int inCellsPerAxis, vec2 inDomainMin, vec2 inDomainMax){
+    domainMin = inDomainMin;
+    domainMax = inDomainMax;
+    setCellsPerAxis(inCellsPerAxis);
+}
+
+void ForceGrid::setCellsPerAxis(int inCellsPerAxis){
+    assert(inCellsPerAxis >= 1);
+    cellsPerAxis = inCellsPerAxis;
+    const vec2 cellSize = (domainMax - domainMin) / static_cast<float>(cellsPerAxis);
+    inverseCellSize = vec2(1.0f / cellSize.x, 1.0f / cellSize.y);
+    dirty = true;
+}
+
+int ForceGrid::getCellsPerAxis() const{
+    return cellsPerAxis;
+}
+
+void ForceGrid::markDirty(){
+    dirty = true;
+}
+
+bool ForceGrid::isDirty() const{
+    return dirty;
+}
+
+int ForceGrid::cellIndex(vec2 position) const{
+    //Partiklar utanför domänen hamnar i kantcellerna
+    const int ix = std::clamp(static_cast<int>(std::floor((position.x - domainMin.x) * inverseCellSize.x)), 0, cellsPerAxis - 1);
+    const int iy = std::clamp(static_cast<int>(std::floor((position.y - domainMin.y) * inverseCellSize.y)), 0, cellsPerAxis - 1);
+    return iy * cellsPerAxis + ix;
+}
+
+void ForceGrid::build(const std::vector<GravityWell*>& wells, const std::vector<Wind*>& winds,
+                      bool preciseGravity)
+{
+    ZoneScoped
+
+    const std::size_t numberOfCells = static_cast<std::size_t>(cellsPerAxis) * cellsPerAxis;
+    std::vector<std::vector<GravityWell*>> cellWells(numberOfCells);
+    cells.assign(numberOfCells, Cell());
+    globalWinds.clear();
+    std::vector<GravityWell*> globalWells;
+
+    //Gå igenom alla celler som överlappar kraftens radie (via dess omslutande kvadrat)
+    auto forEachOverlappedCell = [this](const Force* f, auto&& callback){
+        const vec2 center = f->getPosition();
+        const float radius = f->getInfluenceRadius();
+        const int minX = cellIndex(center - radius) % cellsPerAxis;
+        const int minY = cellIndex(center - radius) / cellsPerAxis;
+        const int maxX = cellIndex(center + radius) % cellsPerAxis;
+        const int maxY = cellIndex(center + radius) / cellsPerAxis;
+        for(int y = minY; y <= maxY; y++){
+            for(int x = minX; x <= maxX; x++){
+                callback(static_cast<std::size_t>(y) * cellsPerAxis + x);
+            }
+        }
+    };
+
+    for(GravityWell* w: wells){
+        if(w->isGlobal()){
+            globalWells.push_back(w);
+            continue;
+        }
+        forEachOverlappedCell(w, [&](std::size_t c){
+            cellWells[c].push_back(w);
+        });
+    }
+    for(Wind* w: winds){
+        if(w->isGlobal()){
+            globalWinds.push_back(w);
+            continue;
+        }
+        forEachOverlappedCell(w, [&](std::size_t c){
+            cells[c].winds.push_back(w);
+        });
+    }
+
+    for(std::size_t c = 0; c < numberOfCells; c++){
+        cells[c].gravity.setWells(cellWells[c]);
+        cells[c].gravity.setPrecise(preciseGravity);
+        cells[c].empty = cellWells[c].empty() && cells[c].winds.empty();
+    }
+    globalGravity.setWells(globalWells);
+    globalGravity.setPrecise(preciseGravity);
+    dirty = false;
+}
+
+void ForceGrid::accumulate(const vec2* positions, vec2* forces, std::size_t count){
+    ZoneScoped
+    assert(!dirty);
+
+    //Globala krafter påverkar alla partiklar
+    globalGravity.accumulate(positions, forces, count);
+    for(Wind* w: globalWinds){
+        w->accumulateForces(positions, forces, count);
+    }
+
+    //Sortera partiklarna per cell (counting sort) så att varje cell blir ett block
+    const std::size_t numberOfCells = cells.size();
+    particleCell.resize(count);
+    cellStart.assign(numberOfCells + 1, 0);
+    for(std::size_t i = 0; i < count; i++){
+        particleCell[i] = static_cast<std::uint32_t>(cellIndex(positions[i]));
+        cellStart[particleCell[i] + 1]++;
+    }
+    for(std::size_t c = 0; c < numberOfCells; c++){
+        cellStart[c + 1] += cellStart[c];
+    }
+    order.resize(count);
+    {
+        std::vector<std::uint32_t> next(cellStart.begin(), cellStart.end() - 1);
+        for(std::size_t i = 0; i < count; i++){
+            order[next[particleCell[i]]++] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    for(std::size_t c = 0; c < numberOfCells; c++){
+        const Cell& cell = cells[c];
+        const std::size_t begin = cellStart[c];
+        const std::size_t blockSize = cellStart[c + 1] - begin;
+        if(cell.empty || blockSize == 0){
+            continue;
+        }
+
+        blockPositions.resize(blockSize);
+        blockForces.assign(blockSize, vec2(0.0f, 0.0f));
+        for(std::size_t k = 0; k < blockSize; k++){
+            blockPositions[k] = positions[order[begin + k]];
+        }
+
+        cell.gravity.accumulate(blockPositions.data(), blockForces.data(), blockSize);
+        for(Wind* w: cell.winds){
+            w->accumulateForces(blockPositions.data(), blockForces.data(), blockSize);
+        }
+
+        for(std::size_t k = 0; k < blockSize; k++){
+            forces[order[begin + k]] += blockForces[k];
+        }
+    }
+}
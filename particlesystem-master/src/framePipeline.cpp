@@ -0,0 +1,158 @@
+//
+//  framePipeline.cpp
+//  ParticleSystem
+//
+
+#include "framePipeline.hpp"
+
+#include "Tracy.hpp"
+#include <algorithm>
+#include <cassert>
+
+FramePipeline::FramePipeline(ParticleSystem& inSystem, int inDepth,
+                             std::function<void(const RenderData&)> inDraw)
+    : system(inSystem), draw(std::move(inDraw)){
+    depth = std::clamp(inDepth, 0, MaxDepth);
+    start();
+}
+
+FramePipeline::~FramePipeline(){
+    stop();
+}
+
+void FramePipeline::setDepth(int inDepth){
+    inDepth = std::clamp(inDepth, 0, MaxDepth);
+    if(inDepth == depth){
+        return;
+    }
+    stop();
+    depth = inDepth;
+    start();
+}
+
+int FramePipeline::getDepth() const{
+    return depth;
+}
+
+void FramePipeline::execute(std::function<void(ParticleSystem&)> command){
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.push_back(std::move(command));
+}
+
+void FramePipeline::runFrame(const Step& step){
+    ZoneScoped
+    if(depth == 0){
+        std::vector<std::function<void(ParticleSystem&)>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.swap(commands);
+        }
+        runCommands(pending);
+        system.updateAndPack(step.dt, step.numberOfSpawnDirections, step.angle, *buffers.front());
+        draw(*buffers.front());
+        drawnParticles = buffers.front()->particles.size();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    steps.push_back(step);
+    framesInFlight++;
+    stepQueued.notify_one();
+
+    //De första depth bildrutorna finns inget färdigt att rita
+    if(framesInFlight <= depth){
+        return;
+    }
+
+    RenderData* frame = nullptr;
+    {
+        ZoneScopedN("Wait for simulation")
+        frameFinished.wait(lock, [this](){ return !finishedFrames.empty(); });
+        frame = finishedFrames.front();
+        finishedFrames.pop_front();
+    }
+    lock.unlock();
+
+    draw(*frame);
+    drawnParticles = frame->particles.size();
+
+    lock.lock();
+    freeBuffers.push_back(frame);
+    framesInFlight--;
+    stepQueued.notify_one();
+}
+
+std::size_t FramePipeline::getDrawnParticleCount() const{
+    return drawnParticles;
+}
+
+void FramePipeline::runCommands(std::vector<std::function<void(ParticleSystem&)>>& pending){
+    for(std::function<void(ParticleSystem&)>& command: pending){
+        command(system);
+    }
+    pending.clear();
+}
+
+void FramePipeline::simulationLoop(){
+    std::vector<std::function<void(ParticleSystem&)>> pending;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        stepQueued.wait(lock, [this](){
+            return stopping || (!steps.empty() && !freeBuffers.empty());
+        });
+        if(stopping){
+            return;
+        }
+        const Step step = steps.front();
+        steps.pop_front();
+        RenderData* frame = freeBuffers.back();
+        freeBuffers.pop_back();
+        pending.swap(commands);
+        lock.unlock();
+
+        {
+            ZoneScopedN("Simulation step")
+            runCommands(pending);
+            system.updateAndPack(step.dt, step.numberOfSpawnDirections, step.angle, *frame);
+        }
+
+        lock.lock();
+        finishedFrames.push_back(frame);
+        frameFinished.notify_one();
+    }
+}
+
+void FramePipeline::start(){
+    //En buffert per bildruta i kön plus den som fylls i
+    buffers.clear();
+    freeBuffers.clear();
+    for(int i = 0; i < depth + 1; i++){
+        buffers.push_back(std::make_unique<RenderData>());
+        freeBuffers.push_back(buffers.back().get());
+    }
+    if(depth == 0){
+        return;
+    }
+    stopping = false;
+    simulationThread = std::thread(&FramePipeline::simulationLoop, this);
+}
+
+void FramePipeline::stop(){
+    if(!simulationThread.joinable()){
+        return;
+    }
+    {
+        //Låt simuleringen bli klar med de steg som redan är köade
+        std::unique_lock<std::mutex> lock(mutex);
+        frameFinished.wait(lock, [this](){
+            return steps.empty() && static_cast<int>(finishedFrames.size()) == framesInFlight;
+        });
+        stopping = true;
+    }
+    stepQueued.notify_one();
+    simulationThread.join();
+
+    finishedFrames.clear();
+    framesInFlight = 0;
+    steps.clear();
+}
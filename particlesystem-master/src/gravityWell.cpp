@@ -6,24 +6,110 @@
 //
 
 #include "gravityWell.hpp"
+#include "util/vec2xN.h"
+#include "Tracy.hpp"
+#include <algorithm>
 
-GravityWell::GravityWell(vec2 inPosition, float inSize, Color inColor): Force(inPosition, inSize, inColor){};
+namespace {
+    constexpr float MinDistanceSquared = 1e-12f;
+} // namespace
+
+GravityWell::GravityWell(vec2 inPosition, float inSize, Color inColor, float inSoftening, float inRadius): Force(inPosition, inSize, inColor, inRadius){
+    softening = inSoftening;
+};
 
 vec2 GravityWell::computeForce(vec2 particlePosition){
  
     vec2 dist = position-particlePosition;
     //vec2 dist = particlePosition-position; //Blir repeller istället
+
+    //Riktning och styrka i ett: C*dist/|dist|^3, med mjukning nära brunnen.
+    //Bara en sqrt istället för normalized() och två length()
+    float rawDistSquared = dist.x*dist.x + dist.y*dist.y;
+    float distSquared = std::max(rawDistSquared + softening*softening, MinDistanceSquared);
+    float inverseDist = 1.0f/std::sqrt(distSquared);
     
-    //Beräkna rikting m.h.a. normalized()
-    vec2 norm = dist.normalized();
-    //float particleAngle = atan(dist.x/dist.y); //Använd hellre vektorer genomgående
-    
-    //Beräkna windPower(styrkan på gravitationen)
-    float C = 1.0f; //gravitationskonstant, värdet kan sättas fritt
-    float gravityMagnitude = C/(dist.length()*dist.length()); //double kan ha 15 decimaler, float kan ha 7 decimaler
-    
-    //vec2 force = {gravityMagnitude*cos(particleAngle), gravityMagnitude*sin(particleAngle)};
-    vec2 force = norm*gravityMagnitude;
-    
-    return force;
+    return dist*(strength*falloff(rawDistSquared)*inverseDist*inverseDist*inverseDist);
+}
+
+void GravityWell::setSoftening(float inSoftening){
+    softening = inSoftening;
+}
+
+float GravityWell::getSoftening() const{
+    return softening;
+}
+
+float GravityWell::getStrength() const{
+    return strength;
+}
+
+void GravityKernel::setWells(const std::vector<GravityWell*>& wells){
+    wellX.clear();
+    wellY.clear();
+    wellStrength.clear();
+    wellSofteningSquared.clear();
+    wellInverseRadiusSquared.clear();
+    for(const GravityWell* w: wells){
+        wellX.push_back(w->getPosition().x);
+        wellY.push_back(w->getPosition().y);
+        wellStrength.push_back(w->getStrength());
+        wellSofteningSquared.push_back(w->getSoftening()*w->getSoftening());
+        const float radius = w->getInfluenceRadius();
+        wellInverseRadiusSquared.push_back(radius > 0.0f ? 1.0f/(radius*radius) : 0.0f);
+    }
+}
+
+void GravityKernel::setPrecise(bool inPrecise){
+    precise = inPrecise;
+}
+
+bool GravityKernel::isPrecise() const{
+    return precise;
+}
+
+void GravityKernel::accumulate(const vec2* positions, vec2* forces, std::size_t count) const{
+    ZoneScoped
+    const std::size_t numberOfWells = wellX.size();
+    if(numberOfWells == 0){
+        return;
+    }
+
+    std::size_t i = 0;
+    using simd::floatv;
+    using simd::vec2v;
+    constexpr std::size_t Width = simd::NativeWidth;
+
+    //Width partiklar i taget, alla brunnar summeras i register innan något skrivs
+    for(; i + Width <= count; i += Width){
+        const vec2v p = vec2v::load(positions + i);
+        vec2v sum = vec2v(vec2(0.0f, 0.0f));
+
+        for(std::size_t w = 0; w < numberOfWells; w++){
+            const vec2v dist = vec2v(vec2(wellX[w], wellY[w])) - p;
+            const floatv rawDistSquared = dist.lengthSquared();
+            const floatv distSquared = simd::max(rawDistSquared + wellSofteningSquared[w], floatv(MinDistanceSquared));
+
+            //Mjuk avtagning (1 - d^2/r^2)^2 inom radien, 1 för globala brunnar
+            floatv weight = simd::max(1.0f - rawDistSquared*wellInverseRadiusSquared[w], floatv(0.0f));
+            weight = weight*weight;
+
+            const floatv inverseDist = precise ? 1.0f/simd::sqrt(distSquared) : simd::rsqrtFast(distSquared);
+            sum += dist*(wellStrength[w]*weight*(inverseDist*inverseDist*inverseDist));
+        }
+        sum.addTo(forces + i);
+    }
+
+    for(; i < count; i++){
+        vec2 sum = {0.0f, 0.0f};
+        for(std::size_t w = 0; w < numberOfWells; w++){
+            const vec2 dist = vec2(wellX[w], wellY[w]) - positions[i];
+            const float rawDistSquared = dist.x*dist.x + dist.y*dist.y;
+            const float distSquared = std::max(rawDistSquared + wellSofteningSquared[w], MinDistanceSquared);
+            const float inverseDist = 1.0f/std::sqrt(distSquared);
+            const float weight = std::max(1.0f - rawDistSquared*wellInverseRadiusSquared[w], 0.0f);
+            sum += dist*(wellStrength[w]*weight*weight*inverseDist*inverseDist*inverseDist);
+        }
+        forces[i] += sum;
+    }
 }
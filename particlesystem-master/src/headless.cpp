@@ -0,0 +1,87 @@
+#include "particlesystem.h"
+#include "scenario.hpp"
+#include "util/perfstats.h"
+#include "util/threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Runs a scenario without opening a window and prints timing statistics for the
+// simulation, so that builds and machines can be compared on the same load.
+//
+//   headless <preset or scenario file> [--frames <count>]
+//   headless --list
+
+namespace {
+    void printUsage() {
+        std::printf("Usage: headless <preset or scenario file> [--frames <count>]\n");
+        std::printf("       headless --list\n\nPresets:\n");
+        for (const std::string& name : getScenarioPresets()) {
+            std::printf("  %-16s %s\n", name.c_str(), getScenarioPreset(name).name.c_str());
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::string(argv[1]) == "--list") {
+        printUsage();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    const std::string source = argv[1];
+    int frames = 0;
+    for (int i = 2; i < argc; i++) {
+        if (std::string(argv[i]) == "--frames" && i + 1 < argc) {
+            frames = std::atoi(argv[++i]);
+        }
+        else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    Scenario scenario;
+    try {
+        const std::vector<std::string> presets = getScenarioPresets();
+        const bool isPreset = std::find(presets.begin(), presets.end(), source) != presets.end();
+        scenario = isPreset ? getScenarioPreset(source) : loadScenario(source);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (frames <= 0) {
+        frames = std::max(1, static_cast<int>(std::ceil(scenario.duration / scenario.timestep)));
+    }
+
+    ParticleSystem system;
+    applyScenario(scenario, system);
+    std::printf("%s\n%zu emitters, %zu forces, %u threads, %d frames of %.4f s\n",
+                scenario.name.c_str(), system.getNumberOfEmitters(), system.getNumberOfForces(),
+                ThreadPool::global().getNumberOfThreads(), frames, scenario.timestep);
+
+    perf::SampleRing updateTimes(static_cast<std::size_t>(frames));
+    double totalTime = 0.0;
+    double particleUpdates = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        const auto start = std::chrono::steady_clock::now();
+        system.update(scenario.timestep, scenario.numberOfSpawnDirections, scenario.angle);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        updateTimes.push(static_cast<float>(elapsed.count()));
+        totalTime += elapsed.count();
+        particleUpdates += static_cast<double>(system.getParticles().size());
+    }
+
+    std::printf("Particles at end   %zu\n", system.getParticles().size());
+    std::printf("Update time        mean %.3f ms  p50 %.3f ms  p95 %.3f ms  p99 %.3f ms\n",
+                updateTimes.mean() * 1000.0f, updateTimes.percentile(50.0f) * 1000.0f,
+                updateTimes.percentile(95.0f) * 1000.0f, updateTimes.percentile(99.0f) * 1000.0f);
+    std::printf("Total time         %.3f s\n", totalTime);
+    std::printf("Throughput         %.2f M particle updates/s\n", particleUpdates / totalTime * 1e-6);
+    return EXIT_SUCCESS;
+}
@@ -1,11 +1,13 @@
 #include "Tracy.hpp"
 #include "particlesystem.h"
+#include "scenario.hpp"
+#include "framePipeline.hpp"
 #include "util/rendering.h"
+#include "util/perfstats.h"
+#include "util/log.h"
 
 #include <algorithm>
 #include <iterator>
-#include <random>
-#include <iostream>
 
 // A function strictly used to exemplify the
 // render[Particles/Emitters/Forces] functions.
@@ -18,10 +20,11 @@ namespace {
     
 }
 
-int main(int, char**) {
+int main(int argc, char** argv) {
     rendering::createWindow();
 
     ParticleSystem particleSystem;
+    std::vector<std::string> scenarioPresets = getScenarioPresets();
 
     float speed = 1.0f;
     bool isRunning = true;
@@ -29,13 +32,67 @@ int main(int, char**) {
     float angle = Pi/4;
     //float angleForce = Pi/4;
     vec2 position = {0.0f,0.0f};
+    EmitterJitter jitter;
+    bool fireworks = false;
+    float shapeSize = 0.2f;
+    //Två steg: en gul burst där partikeln dör och en röd där den gula dör
+    std::vector<SubEmitterDescription> fireworkStages(2);
+    fireworkStages[1].count = 6;
+    fireworkStages[1].speed = 0.1f;
+    fireworkStages[1].archetype.color = {1.0f, 0.35f, 0.2f};
+    fireworkStages[1].archetype.lifetime = 0.5f;
+    bool useForceField = false;
+    int forceFieldResolution = 128;
+    float gravitySoftening = 0.01f;
+    bool preciseGravity = false;
+    float forceRadius = 0.0f;
+    bool cullForces = false;
+    bool nBody = false;
+    float openingAngle = 0.5f;
+    bool particleMesh = false;
+    int particleMeshLevel = 7;
+    int particleMeshInterval = 1;
+    bool debugLogging = false;
+    int pipelineDepth = 1;
+
+    //Alla ändringar av particleSystem går via pipelinen, simuleringen körs på en egen tråd
+    FramePipeline pipeline(particleSystem, pipelineDepth);
+    //Handtag till det som lagts till via UI:t, används bara inuti kommandon till pipelinen
+    //så de rörs aldrig av två trådar samtidigt
+    std::vector<EmitterHandle> addedEmitters;
+    std::vector<ForceHandle> addedForces;
+
+    //Ladda ett scenario, från en fil eller ett förinställt, och synka UI:t med det
+    auto startScenario = [&](const Scenario& scenario){
+        pipeline.execute([&, scenario](ParticleSystem& s){
+            applyScenario(scenario, s);
+            addedEmitters.clear();
+            addedForces.clear();
+        });
+        numberOfSpawnDirections = scenario.numberOfSpawnDirections;
+        angle = scenario.angle;
+        useForceField = scenario.forceField;
+        cullForces = scenario.forceCulling;
+        nBody = scenario.nBody;
+        particleMesh = scenario.particleMesh;
+        preciseGravity = scenario.preciseGravity;
+        gravitySoftening = scenario.gravitySoftening;
+        LOG_INFO("Started scenario %s", scenario.name.c_str());
+    };
+    if(argc > 1){
+        try{
+            startScenario(loadScenario(argv[1]));
+        }
+        catch(const std::exception& e){
+            LOG_ERROR("%s", e.what());
+        }
+    }
     while (isRunning) {
         const float dt = rendering::beginFrame();
 
         {
 
-            std::cout << "IM HERE" << std::endl;
-             //printf("%s\n", (__LINE__));
+            LOG_DEBUG("Frame start, dt = %f", dt);
 
             ui::GuiScope ui;  // Initiates and finalizes UI rendering upon
                               // construction/destruction
@@ -45,43 +102,149 @@ int main(int, char**) {
             
             ui::beginGroup("Lägg till emitters");
                 ui::sliderVec2("Position", position, -1.0f, 1.0f);
+                //Slumpad variation för nya emitters
+                ui::sliderFloat("Angle jitter", jitter.angle, 0.0f, Pi);
+                ui::sliderFloat("Speed jitter", jitter.speed, 0.0f, 1.0f);
+                ui::sliderFloat("Lifetime jitter", jitter.lifetime, 0.0f, 1.0f);
+                ui::sliderFloat("Color jitter", jitter.color, 0.0f, 0.5f);
+                ui::checkbox("Fireworks when particles die", fireworks);
                 if(ui::button("Add uniform emitter")){
-                    particleSystem.addUniform(position); //Lägga till uniform emitter
+                    pipeline.execute([&, position, jitter, fireworks](ParticleSystem& s){ //Lägga till uniform emitter
+                        addedEmitters.push_back(s.addUniform(position));
+                        s.setEmitterJitter(addedEmitters.back(), jitter);
+                        if(fireworks){
+                            s.addSubEmitters(addedEmitters.back(), fireworkStages);
+                        }
+                    });
                 }
                 if(ui::button("Add directional emitter")){
-                    particleSystem.addDirectional(position); //Lägga till directional emitter
+                    pipeline.execute([&, position, jitter, fireworks](ParticleSystem& s){ //Lägga till directional emitter
+                        addedEmitters.push_back(s.addDirectional(position));
+                        s.setEmitterJitter(addedEmitters.back(), jitter);
+                        if(fireworks){
+                            s.addSubEmitters(addedEmitters.back(), fireworkStages);
+                        }
+                    });
+                }
+                //Formemitters sprider partiklarna över en yta eller linje runt positionen
+                ui::sliderFloat("Shape size", shapeSize, 0.01f, 1.0f);
+                if(ui::button("Add disc emitter")){
+                    pipeline.execute([&, position, jitter, shapeSize](ParticleSystem& s){
+                        addedEmitters.push_back(s.addShape(position, EmitterShape::disc(shapeSize)));
+                        s.setEmitterJitter(addedEmitters.back(), jitter);
+                    });
+                }
+                if(ui::button("Add line emitter")){
+                    pipeline.execute([&, position, jitter, shapeSize](ParticleSystem& s){
+                        addedEmitters.push_back(s.addShape(position, EmitterShape::line({-shapeSize, 0.0f}, {shapeSize, 0.0f})));
+                        s.setEmitterJitter(addedEmitters.back(), jitter);
+                    });
+                }
+                if(ui::button("Remove latest emitter")){
+                    pipeline.execute([&](ParticleSystem& s){
+                        //Handtag som redan tagits bort, t.ex. av clear, hoppas över
+                        while(!addedEmitters.empty() && !s.removeEmitter(addedEmitters.back())){
+                            addedEmitters.pop_back();
+                        }
+                        if(!addedEmitters.empty()){
+                            addedEmitters.pop_back();
+                        }
+                    });
                 }
             ui::endGroup();
-            /*if(ui::button("Remove latest emitter")){
-                particleSystem.removeLatestEmitter();
-            }*/
             
             ui::beginGroup("Lägg till forces");
+                ui::sliderFloat("Radius (0 = global)", forceRadius, 0.0f, 2.0f);
                 if(ui::button("Add gravity well")){
-                    particleSystem.addGravityWell(position); //Lägga till gravity well
+                    pipeline.execute([&, position, forceRadius](ParticleSystem& s){ addedForces.push_back(s.addGravityWell(position, forceRadius)); }); //Lägga till gravity well
                 }
                 if(ui::button("Add wind")){
-                    particleSystem.addWind(position); //Lägga till wind
+                    pipeline.execute([&, position, forceRadius](ParticleSystem& s){ addedForces.push_back(s.addWind(position, forceRadius)); }); //Lägga till wind
+                }
+                if(ui::button("Remove latest force")){
+                    pipeline.execute([&](ParticleSystem& s){
+                        while(!addedForces.empty() && !s.removeForce(addedForces.back())){
+                            addedForces.pop_back();
+                        }
+                        if(!addedForces.empty()){
+                            addedForces.pop_back();
+                        }
+                    });
                 }
             ui::endGroup();
             
             
+            ui::beginGroup("Scenarier");
+                for(const std::string& name: scenarioPresets){
+                    if(ui::button(name.c_str())){
+                        startScenario(getScenarioPreset(name));
+                    }
+                }
+                if(ui::button("Clear")){
+                    pipeline.execute([&](ParticleSystem& s){
+                        s.clear();
+                        addedEmitters.clear();
+                        addedForces.clear();
+                    });
+                }
+            ui::endGroup();
+            
             ui::beginGroup("Inställningar");
                 ui::sliderFloat("Antal strålar för uniform emitter", numberOfSpawnDirections, 1.0f, 360.0f);
                 ui::sliderFloat("Vinkel för directional emitter", angle, 0.0f, 2*Pi);
                 //ui::sliderFloat("Vinkel för wind", angleForce, 0.0f, 2 * Pi);
+                if(ui::checkbox("Bake forces into grid", useForceField)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setForceFieldEnabled(useForceField); });
+                }
+                if(ui::sliderInt("Force grid resolution", forceFieldResolution, 8, 512)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setForceFieldResolution(forceFieldResolution); });
+                }
+                if(ui::sliderFloat("Gravity softening", gravitySoftening, 0.0f, 0.2f)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setGravitySoftening(gravitySoftening); });
+                }
+                if(ui::checkbox("Precise gravity", preciseGravity)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setPreciseGravity(preciseGravity); });
+                }
+                if(ui::checkbox("Cull forces by radius", cullForces)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setForceCullingEnabled(cullForces); });
+                }
+                if(ui::checkbox("Particles attract each other", nBody)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setNBodyEnabled(nBody); });
+                }
+                if(ui::sliderFloat("Barnes-Hut opening angle", openingAngle, 0.0f, 1.5f)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setNBodyOpeningAngle(openingAngle); });
+                }
+                if(ui::checkbox("Particle-mesh gravity", particleMesh)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setParticleMeshEnabled(particleMesh); });
+                }
+                //Upplösningen måste vara en tvåpotens, slidern väljer exponenten
+                if(ui::sliderInt("Mesh resolution (2^n)", particleMeshLevel, 4, 9)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setParticleMeshResolution(1 << particleMeshLevel); });
+                }
+                if(ui::sliderInt("Mesh update interval", particleMeshInterval, 1, 10)){
+                    pipeline.execute([=](ParticleSystem& s){ s.setParticleMeshUpdateInterval(particleMeshInterval); });
+                }
+                //Varje steg i pipelinen ger en bildrutas fördröjning
+                if(ui::sliderInt("Pipeline depth (frames of latency)", pipelineDepth, 0, FramePipeline::MaxDepth)){
+                    pipeline.setDepth(pipelineDepth);
+                }
+                if(ui::checkbox("Debug logging", debugLogging)){
+                    logging::setLevel(debugLogging ? logging::Level::Debug : logging::Level::Info);
+                }
             ui::endGroup();
             
             
+            perf::showPanel();
+            
             ui::sliderFloat("Simulation speed", speed, 0.001f, 10.0f);
             if (ui::button("Close application")) {
                 isRunning = false;
             }
         }
 
-        particleSystem.update(dt * speed, numberOfSpawnDirections, angle);
-        particleSystem.render();
-
+        //Simulera nästa steg medan det förra ritas, se FramePipeline
+        pipeline.runFrame({dt * speed, numberOfSpawnDirections, angle});
+        perf::endFrame(dt, pipeline.getDrawnParticleCount());
 
         isRunning &= rendering::endFrame();
     }
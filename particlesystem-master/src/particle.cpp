@@ -8,36 +8,43 @@
 #include "particle.h"
 #include <iostream>
 
-Particle::Particle(vec2 inPosition, float inRadius, Color inColor, float inMass, vec2 inVelocity){
+Particle::Particle(vec2 inPosition, vec2 inVelocity, std::uint32_t inArchetype, float inLifetime){
     position = inPosition;
-    radius = inRadius;
-    color = inColor;
-    lifetime = 60.0f;
-    mass = inMass;
     velocity = inVelocity;
+    archetype = inArchetype;
+    lifetime = inLifetime;
 }
 
-void Particle::updateSingleParticle(float dt, vec2 inputForce){
-    vec2 acceleration = inputForce/mass;
+void Particle::updateSingleParticle(float dt, vec2 inputForce, float inverseMass){
+    vec2 acceleration = inputForce*inverseMass;
     velocity = velocity + acceleration*dt;
     position = position + velocity*dt;
     
     lifetime -= dt;
 }
 
-float Particle::getLifeTime(){
+float Particle::getLifeTime() const{
     return lifetime;
 }
 
-vec2 Particle::getPosition(){
+vec2 Particle::getVelocity() const{
+    return velocity;
+}
+
+vec2 Particle::getPosition() const{
     return position;
 }
 
-rendering::ParticleInfo Particle::toParticleInfo(){
+std::uint32_t Particle::getArchetype() const{
+    return archetype;
+}
+
+rendering::ParticleInfo Particle::toParticleInfo(const ParticleArchetypeTable& archetypes) const{
+    const ParticleArchetype& a = archetypes[archetype];
     rendering::ParticleInfo particleInfo;
     particleInfo.position = position;
-    particleInfo.radius = radius;
-    particleInfo.color = color;
+    particleInfo.radius = a.radius;
+    particleInfo.color = a.color;
     particleInfo.lifetime = lifetime;
     return particleInfo;
 };
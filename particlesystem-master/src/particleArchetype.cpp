@@ -0,0 +1,73 @@
+//
+//  particleArchetype.cpp
+//  ParticleSystem
+//
+
+#include "particleArchetype.hpp"
+
+#include <cassert>
+
+bool isSame(const ParticleArchetype& a, const ParticleArchetype& b){
+    return a.radius == b.radius && a.color.r == b.color.r && a.color.g == b.color.g &&
+           a.color.b == b.color.b && a.inverseMass == b.inverseMass && a.lifetime == b.lifetime;
+}
+
+std::uint32_t ParticleArchetypeTable::add(const ParticleArchetype& archetype){
+    assert(archetype.inverseMass > 0.0f);
+
+    //Tabellen är liten, en linjär sökning räcker
+    for(std::size_t i = 0; i < archetypes.size(); i++){
+        if(shared[i] && isSame(archetypes[i], archetype)){
+            return static_cast<std::uint32_t>(i);
+        }
+    }
+    const std::uint32_t index = addUnique(archetype);
+    shared[index] = true;
+    return index;
+}
+
+std::uint32_t ParticleArchetypeTable::addUnique(const ParticleArchetype& archetype){
+    assert(archetype.inverseMass > 0.0f);
+    if(!released.empty()){
+        const std::uint32_t index = released.back();
+        released.pop_back();
+        archetypes[index] = archetype;
+        masses[index] = 1.0f / archetype.inverseMass;
+        return index;
+    }
+    archetypes.push_back(archetype);
+    masses.push_back(1.0f / archetype.inverseMass);
+    shared.push_back(false);
+    return static_cast<std::uint32_t>(archetypes.size() - 1);
+}
+
+void ParticleArchetypeTable::release(std::uint32_t index){
+    assert(index < shared.size() && !shared[index]);
+    released.push_back(index);
+}
+
+bool ParticleArchetypeTable::isShared(std::uint32_t index) const{
+    assert(index < shared.size());
+    return shared[index];
+}
+
+const ParticleArchetype& ParticleArchetypeTable::operator[](std::uint32_t index) const{
+    assert(index < archetypes.size());
+    return archetypes[index];
+}
+
+float ParticleArchetypeTable::getMass(std::uint32_t index) const{
+    assert(index < masses.size());
+    return masses[index];
+}
+
+std::size_t ParticleArchetypeTable::size() const{
+    return archetypes.size();
+}
+
+void ParticleArchetypeTable::clear(){
+    archetypes.clear();
+    masses.clear();
+    shared.clear();
+    released.clear();
+}
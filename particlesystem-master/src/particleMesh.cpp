@@ -0,0 +1,307 @@
+//
+//  particleMesh.cpp
+//  ParticleSystem
+//
+
+#include "particleMesh.hpp"
+
+#include "Tracy.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+    constexpr float Pi = 3.141592654f;
+    constexpr int VCyclesPerSolve = 3;
+    constexpr int SmoothingIterations = 2;
+
+    [[maybe_unused]] bool isPowerOfTwo(int v) {
+        return v > 0 && (v & (v - 1)) == 0;
+    }
+} // namespace
+
+ParticleMesh::ParticleMesh(int inCellsPerAxis, vec2 inDomainMin, vec2 inDomainMax){
+    domainMin = inDomainMin;
+    domainMax = inDomainMax;
+    setCellsPerAxis(inCellsPerAxis);
+}
+
+void ParticleMesh::setCellsPerAxis(int inCellsPerAxis){
+    assert(isPowerOfTwo(inCellsPerAxis) && inCellsPerAxis >= 4);
+    cellsPerAxis = inCellsPerAxis;
+    //Domänen är kvadratisk, den längsta sidan bestämmer cellstorleken
+    cellSize = std::max(domainMax.x - domainMin.x, domainMax.y - domainMin.y) / cellsPerAxis;
+
+    //En nivå per halvering ned till 2x2 celler (en inre nod)
+    levels.clear();
+    for(int cells = cellsPerAxis; cells >= 2; cells /= 2){
+        Level level;
+        level.nodes = cells + 1;
+        level.h = cellSize * (cellsPerAxis / cells);
+        const std::size_t size = static_cast<std::size_t>(level.nodes) * level.nodes;
+        level.potential.assign(size, 0.0f);
+        level.rhs.assign(size, 0.0f);
+        level.residual.assign(size, 0.0f);
+        levels.push_back(std::move(level));
+    }
+
+    const std::size_t size = static_cast<std::size_t>(cellsPerAxis + 1) * (cellsPerAxis + 1);
+    density.assign(size, 0.0f);
+    potential.assign(size, 0.0f);
+    acceleration.assign(size, vec2(0.0f, 0.0f));
+    wellDensity.assign(size, 0.0f);
+    wellPotential.assign(size, 0.0f);
+    wellForce.assign(size, vec2(0.0f, 0.0f));
+    wellsChanged = true;
+    hasSolution = false;
+    stepsSinceUpdate = 0;
+}
+
+int ParticleMesh::getCellsPerAxis() const{
+    return cellsPerAxis;
+}
+
+void ParticleMesh::setUpdateInterval(int steps){
+    updateInterval = std::max(steps, 1);
+}
+
+void ParticleMesh::setGravitationalConstant(float G){
+    gravitationalConstant = G;
+    hasSolution = false;
+}
+
+void ParticleMesh::setWells(const vec2* positions, const float* strengths, std::size_t count){
+    wellPositions.assign(positions, positions + count);
+    wellStrengths.assign(strengths, strengths + count);
+    wellsChanged = true;
+}
+
+void ParticleMesh::clearMasses(){
+    std::fill(density.begin(), density.end(), 0.0f);
+}
+
+void ParticleMesh::depositMasses(const vec2* positions, const float* masses, std::size_t count){
+    ZoneScoped
+    deposit(density, positions, masses, count);
+}
+
+void ParticleMesh::deposit(std::vector<float>& target, const vec2* positions, const float* masses,
+                           std::size_t count) const{
+    const int nodes = cellsPerAxis + 1;
+    const float inverseCellSize = 1.0f / cellSize;
+    //Massan fördelas som densitet, alltså per nodarea h^2
+    const float inverseArea = inverseCellSize * inverseCellSize;
+
+    for(std::size_t i = 0; i < count; i++){
+        const float gx = (positions[i].x - domainMin.x) * inverseCellSize;
+        const float gy = (positions[i].y - domainMin.y) * inverseCellSize;
+        const int ix = static_cast<int>(std::floor(gx));
+        const int iy = static_cast<int>(std::floor(gy));
+        if(ix < 0 || iy < 0 || ix >= cellsPerAxis || iy >= cellsPerAxis){
+            continue; //Utanför domänen bidrar inte
+        }
+        const float fx = gx - ix;
+        const float fy = gy - iy;
+        const float m = masses[i] * inverseArea;
+
+        float* node = target.data() + static_cast<std::size_t>(iy) * nodes + ix;
+        node[0] += m * (1.0f - fx) * (1.0f - fy);
+        node[1] += m * fx * (1.0f - fy);
+        node[nodes] += m * (1.0f - fx) * fy;
+        node[nodes + 1] += m * fx * fy;
+    }
+}
+
+bool ParticleMesh::needsUpdate() const{
+    return !hasSolution || stepsSinceUpdate + 1 >= updateInterval;
+}
+
+void ParticleMesh::smooth(Level& level, int iterations) const{
+    //Röd-svart Gauss-Seidel, randen hålls fast på noll
+    const int n = level.nodes;
+    const float h2 = level.h * level.h;
+    for(int it = 0; it < iterations; it++){
+        for(int color = 0; color < 2; color++){
+            for(int j = 1; j < n - 1; j++){
+                float* row = level.potential.data() + static_cast<std::size_t>(j) * n;
+                const float* rhsRow = level.rhs.data() + static_cast<std::size_t>(j) * n;
+                for(int i = 1 + ((j + color) & 1); i < n - 1; i += 2){
+                    row[i] = 0.25f * (row[i - 1] + row[i + 1] + row[i - n] + row[i + n] - h2 * rhsRow[i]);
+                }
+            }
+        }
+    }
+}
+
+void ParticleMesh::computeResidual(Level& level) const{
+    const int n = level.nodes;
+    const float inverseH2 = 1.0f / (level.h * level.h);
+    std::fill(level.residual.begin(), level.residual.end(), 0.0f);
+    for(int j = 1; j < n - 1; j++){
+        for(int i = 1; i < n - 1; i++){
+            const std::size_t k = static_cast<std::size_t>(j) * n + i;
+            const float* p = level.potential.data();
+            const float laplacian = (p[k - 1] + p[k + 1] + p[k - n] + p[k + n] - 4.0f * p[k]) * inverseH2;
+            level.residual[k] = level.rhs[k] - laplacian;
+        }
+    }
+}
+
+void ParticleMesh::restrictResidual(const Level& fine, Level& coarse) const{
+    //Full viktning av residualen till den grövre nivån
+    const int nf = fine.nodes;
+    const int nc = coarse.nodes;
+    std::fill(coarse.rhs.begin(), coarse.rhs.end(), 0.0f);
+    for(int J = 1; J < nc - 1; J++){
+        for(int I = 1; I < nc - 1; I++){
+            const float* r = fine.residual.data() + static_cast<std::size_t>(2 * J) * nf + 2 * I;
+            coarse.rhs[static_cast<std::size_t>(J) * nc + I] =
+                (4.0f * r[0]
+                 + 2.0f * (r[-1] + r[1] + r[-nf] + r[nf])
+                 + (r[-nf - 1] + r[-nf + 1] + r[nf - 1] + r[nf + 1])) / 16.0f;
+        }
+    }
+}
+
+void ParticleMesh::prolongAndCorrect(const Level& coarse, Level& fine) const{
+    //Bilinjär interpolation av korrektionen tillbaka till den finare nivån
+    const int nf = fine.nodes;
+    const int nc = coarse.nodes;
+    for(int j = 1; j < nf - 1; j++){
+        const int J = j / 2;
+        const bool oddRow = j & 1;
+        for(int i = 1; i < nf - 1; i++){
+            const int I = i / 2;
+            const bool oddColumn = i & 1;
+            const float* e = coarse.potential.data() + static_cast<std::size_t>(J) * nc + I;
+            float correction;
+            if(!oddRow && !oddColumn){
+                correction = e[0];
+            }
+            else if(oddColumn && !oddRow){
+                correction = 0.5f * (e[0] + e[1]);
+            }
+            else if(!oddColumn && oddRow){
+                correction = 0.5f * (e[0] + e[nc]);
+            }
+            else{
+                correction = 0.25f * (e[0] + e[1] + e[nc] + e[nc + 1]);
+            }
+            fine.potential[static_cast<std::size_t>(j) * nf + i] += correction;
+        }
+    }
+}
+
+void ParticleMesh::vCycle(std::size_t levelIndex){
+    Level& level = levels[levelIndex];
+    if(levelIndex + 1 == levels.size()){
+        //Den grövsta nivån har bara en inre nod och löses direkt
+        smooth(level, 1);
+        return;
+    }
+
+    smooth(level, SmoothingIterations);
+    computeResidual(level);
+    Level& coarse = levels[levelIndex + 1];
+    restrictResidual(level, coarse);
+    std::fill(coarse.potential.begin(), coarse.potential.end(), 0.0f);
+    vCycle(levelIndex + 1);
+    prolongAndCorrect(coarse, level);
+    smooth(level, SmoothingIterations);
+}
+
+void ParticleMesh::update(){
+    ZoneScoped
+    if(wellsChanged){
+        //Fältet G*M/r från massan M, här är "massan" brunnens styrka delad med avståndet
+        //där kraften ska vara styrka/r^2 som för GravityWell
+        std::fill(wellDensity.begin(), wellDensity.end(), 0.0f);
+        std::vector<float> masses(wellStrengths.size());
+        for(std::size_t w = 0; w < masses.size(); w++){
+            masses[w] = wellStrengths[w] / WellMatchingDistance;
+        }
+        deposit(wellDensity, wellPositions.data(), masses.data(), masses.size());
+        solve(wellDensity, 2.0f * Pi, wellPotential, wellForce);
+        wellsChanged = false;
+    }
+
+    if(!needsUpdate()){
+        stepsSinceUpdate++;
+        return;
+    }
+    stepsSinceUpdate = 0;
+
+    //Poissons ekvation i 2D: laplace(potential) = 2*pi*G*densitet
+    solve(density, 2.0f * Pi * gravitationalConstant, potential, acceleration);
+    hasSolution = true;
+}
+
+void ParticleMesh::solve(const std::vector<float>& source, float scale, std::vector<float>& inOutPotential,
+                         std::vector<vec2>& field){
+    //Förra lösningen används som startgissning
+    Level& finest = levels[0];
+    finest.potential.swap(inOutPotential);
+    for(std::size_t k = 0; k < source.size(); k++){
+        finest.rhs[k] = scale * source[k];
+    }
+    for(int cycle = 0; cycle < VCyclesPerSolve; cycle++){
+        vCycle(0);
+    }
+
+    //Accelerationen är -grad(potential), centraldifferenser (ensidiga vid randen)
+    const int n = finest.nodes;
+    const float* p = finest.potential.data();
+    for(int j = 0; j < n; j++){
+        const int jm = std::max(j - 1, 0);
+        const int jp = std::min(j + 1, n - 1);
+        for(int i = 0; i < n; i++){
+            const int im = std::max(i - 1, 0);
+            const int ip = std::min(i + 1, n - 1);
+            const float dx = (p[static_cast<std::size_t>(j) * n + ip] - p[static_cast<std::size_t>(j) * n + im]) / ((ip - im) * finest.h);
+            const float dy = (p[static_cast<std::size_t>(jp) * n + i] - p[static_cast<std::size_t>(jm) * n + i]) / ((jp - jm) * finest.h);
+            field[static_cast<std::size_t>(j) * n + i] = vec2(-dx, -dy);
+        }
+    }
+    finest.potential.swap(inOutPotential);
+}
+
+void ParticleMesh::accumulate(const vec2* positions, const float* masses, vec2* forces,
+                              std::size_t count, ThreadPool& pool) const
+{
+    ZoneScoped
+    if(!hasSolution && wellPositions.empty()){
+        return;
+    }
+    const bool particleField = hasSolution;
+    const bool wellField = !wellPositions.empty();
+
+    const int nodes = cellsPerAxis + 1;
+    const float inverseCellSize = 1.0f / cellSize;
+    pool.parallelFor(count, [&](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; i++){
+            const float gx = (positions[i].x - domainMin.x) * inverseCellSize;
+            const float gy = (positions[i].y - domainMin.y) * inverseCellSize;
+            const int ix = static_cast<int>(std::floor(gx));
+            const int iy = static_cast<int>(std::floor(gy));
+            if(ix < 0 || iy < 0 || ix >= cellsPerAxis || iy >= cellsPerAxis){
+                continue;
+            }
+            //Samma cloud-in-cell-vikter som vid deponeringen
+            const float fx = gx - ix;
+            const float fy = gy - iy;
+            const float w00 = (1.0f - fx) * (1.0f - fy);
+            const float w10 = fx * (1.0f - fy);
+            const float w01 = (1.0f - fx) * fy;
+            const float w11 = fx * fy;
+            const std::size_t node = static_cast<std::size_t>(iy) * nodes + ix;
+            if(particleField){
+                const vec2* a = acceleration.data() + node;
+                forces[i] += (a[0] * w00 + a[1] * w10 + a[nodes] * w01 + a[nodes + 1] * w11) * masses[i];
+            }
+            if(wellField){
+                const vec2* f = wellForce.data() + node;
+                forces[i] += f[0] * w00 + f[1] * w10 + f[nodes] * w01 + f[nodes + 1] * w11;
+            }
+        }
+    });
+}
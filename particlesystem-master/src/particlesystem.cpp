@@ -1,116 +1,793 @@
 #include "particlesystem.h"
 
+#include "util/perfstats.h"
+#include "util/log.h"
+#include "util/taskgraph.h"
+#include "util/threadpool.h"
 #include "Tracy.hpp"
+#include <algorithm>
 #include <cmath>
-#include <random>
-#include "uniform.hpp"
-#include "directional.hpp"
-#include "gravityWell.hpp"
-#include "wind.hpp"
-#include <iostream>
 
 namespace {
     constexpr float Pi = 3.141592654f;
     const float Tau = 2.f * Pi;
+    //Antal partiklar per chunk i uppdateringsgrafen, samma chunkar som minnet placeras i
+    constexpr std::size_t ChunkSize = memory::chunkSize;
+    //Så att många små emittrar ändå delas upp på flera tasks
+    constexpr std::size_t MaxEmittersPerTask = 256;
+    //Antal färgvarianter per emitter med färgjitter
+    constexpr std::uint64_t NumberOfColorVariants = 8;
+    constexpr std::uint32_t NumberOfEmitterTypes = 3;
+
+    //Handtagets plats identifierar emittern, så samma scen ger samma slumptal. Generationen
+    //är inte med så att en scen ger samma resultat efter clear som i ett nytt system
+    std::uint32_t streamId(EmitterHandle handle){
+        return NumberOfEmitterTypes * handle.index + static_cast<std::uint32_t>(handle.type);
+    }
     
 } // namespace
 
 ParticleSystem::ParticleSystem() {
-    forces = {};
-    emitters = {};
     particles = {};
 }
 
-void ParticleSystem::update([[maybe_unused]] float dt, float numberOfSpawnDirections, float angle) {
+void ParticleSystem::update(float dt, float numberOfSpawnDirections, float angle) {
+    runUpdate(dt, numberOfSpawnDirections, angle, nullptr);
+}
+
+void ParticleSystem::updateAndPack(float dt, float numberOfSpawnDirections, float angle, RenderData& out) {
+    runUpdate(dt, numberOfSpawnDirections, angle, &out);
+}
+
+void ParticleSystem::runUpdate(float dt, float numberOfSpawnDirections, float angle, RenderData* out) {
+    ZoneScoped
+    perf::ScopedTimer timer(perf::Phase::Simulation);
     // @TODO: Update the state of the particle system, move particles forwards, spawn new
     // particles, destroy old particles, and apply effects
-    
-    //Ta bort döda partiklar
-    int it = 0;
-    for(Particle p: particles){
-        if(p.getLifeTime() <= 0.0f){
-            particles.erase(particles.begin()+it);
+
+    //Vilka krafter som används, samma prioritet som tidigare
+    const bool useForceField = forceFieldEnabled;
+    const bool useParticleMesh = !useForceField && particleMeshEnabled;
+    const bool useForceCulling = !useForceField && !useParticleMesh && forceCullingEnabled;
+    const bool useNBody = nBodyEnabled && !particleMeshEnabled;
+    const bool needsMasses = useParticleMesh || useNBody;
+    //Krafter som behöver alla partiklars positioner samtidigt delar grafen i två delar
+    const bool useGlobalForces = useParticleMesh || useForceCulling || useNBody;
+
+    //Strukturer som bara beror på krafterna byggs innan grafen startar
+    if(useForceField && forceField.isDirty()){
+        forceField.bake(collectForces());
+    }
+    if(useForceCulling && forceGrid.isDirty()){
+        std::vector<GravityWell*> wellPointers;
+        std::vector<Wind*> windPointers;
+        for(GravityWell& w: gravityWells){
+            wellPointers.push_back(&w);
         }
-        else{
-            it++;
+        for(Wind& w: winds){
+            windPointers.push_back(&w);
         }
+        forceGrid.build(wellPointers, windPointers, gravityKernel.isPrecise());
     }
-    
-    //Spawn new particles
-    for(Emitter* e: emitters){
-        //Använda iteratorer för att lägga till med insert
-        std::vector<Particle> newParticles = e -> createParticles(numberOfSpawnDirections, angle);
-        particles.insert(particles.end(), newParticles.begin(), newParticles.end()); //lägg till de skapade particlarna i particles
+
+    //Emittrarna i samma ordning varje gång så att resultatet inte beror på antalet trådar.
+    //Exklusiv prefixsumma, varje emitter får ett eget intervall efter de levande partiklarna
+    emitterScratch.clear();
+    for(Uniform& e: uniforms){
+        emitterScratch.push_back(&e);
     }
-    
-    //Skapa krafter som vektorer
-    //Loopa igenom alla partiklar och beräkna hur den påverkas av systemets forces
-    for(Particle& p: particles){
-        vec2 sumOfForces = {0.0f, 0.0f};
-        for(Force* f: forces){
-            sumOfForces += f -> computeForce(p.getPosition());
+    for(Directional& e: directionals){
+        emitterScratch.push_back(&e);
+    }
+    for(ShapeEmitter& e: shapes){
+        emitterScratch.push_back(&e);
+    }
+    spawnOffsets.resize(emitterScratch.size() + 1);
+    spawnOffsets[0] = 0;
+    for(size_t i = 0; i < emitterScratch.size(); i++){
+        spawnOffsets[i + 1] = spawnOffsets[i] + emitterScratch[i]->getSpawnCount();
+        emitterScratch[i]->setTimestep(dt);
+    }
+
+    //En chunk per ChunkSize gamla partiklar, sen grupper av emittrar med ungefär lika många nya
+    const size_t numberOfParticles = particles.size();
+    const size_t numberOfChunks = (numberOfParticles + ChunkSize - 1) / ChunkSize;
+    spawnGroups.clear();
+    for(size_t first = 0, i = 0; i < emitterScratch.size(); i++){
+        if(spawnOffsets[i + 1] - spawnOffsets[first] >= ChunkSize || i + 1 - first >= MaxEmittersPerTask
+           || i + 1 == emitterScratch.size()){
+            spawnGroups.push_back({first, i + 1});
+            first = i + 1;
+        }
+    }
+    //Döda partiklar med en sub-emitter ger en burst per chunk, efter emittrarnas partiklar
+    const bool useSubEmitters = !subEmitters.empty();
+    const size_t firstBurstRange = numberOfChunks + spawnGroups.size();
+    const size_t numberOfBurstRanges = useSubEmitters ? numberOfChunks : 0;
+    deathOffsets.assign(numberOfChunks + 1, 0);
+    burstOffsets.assign(numberOfChunks + 1, 0);
+    if(burstScratch.size() < numberOfBurstRanges){
+        burstScratch.resize(numberOfBurstRanges);
+    }
+
+    //Varje chunk och grupp producerar ett intervall i backParticles, räknas ut av scan
+    chunkOffsets.assign(numberOfChunks + 1, 0);
+    producedRanges.resize(firstBurstRange + numberOfBurstRanges);
+    size_t numberOfLive = 0;
+    size_t numberOfTotal = 0;
+
+    auto prepare = [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+            positionScratch[i] = backParticles[i].getPosition();
+            forceScratch[i] = vec2(0.0f, 0.0f);
+        }
+        if(needsMasses){
+            for(size_t i = first; i < last; i++){
+                massScratch[i] = archetypes.getMass(backParticles[i].getArchetype());
+            }
         }
-        p.updateSingleParticle(dt, sumOfForces);
+    };
 
+    TaskGraph& graph = updateGraph;
+    ThreadPool& pool = ThreadPool::global();
+    const unsigned numberOfThreads = pool.getNumberOfThreads();
+    //Tasks för en chunk körs helst på tråden som äger chunkens minne
+    auto preferOwner = [&](TaskGraph::TaskId task, size_t firstParticle){
+        graph.setPreferredThread(task, ThreadPool::chunkOwner(firstParticle/ChunkSize, numberOfThreads));
+    };
+    std::vector<TaskGraph::TaskId> producers;
+    producers.reserve(producedRanges.size());
+    {
+        //Räkna levande partiklar per chunk, sen en liten scan över chunkarna
+        graph.clear();
+        for(size_t c = 0; c < numberOfChunks; c++){
+            const TaskGraph::TaskId count = graph.add("Count live particles", [&, c](){
+                const size_t last = std::min((c + 1) * ChunkSize, numberOfParticles);
+                size_t live = 0;
+                size_t deaths = 0;
+                size_t bursts = 0;
+                for(size_t i = c * ChunkSize; i < last; i++){
+                    if(particles[i].getLifeTime() > 0.0f){
+                        live++;
+                    }
+                    else if(useSubEmitters){
+                        const std::int32_t s = subEmitterFor(particles[i].getArchetype());
+                        if(s >= 0){
+                            deaths++;
+                            bursts += subEmitters[s].getBurstSize();
+                        }
+                    }
+                }
+                chunkOffsets[c + 1] = live;
+                deathOffsets[c + 1] = deaths;
+                burstOffsets[c + 1] = bursts;
+            });
+            preferOwner(count, c*ChunkSize);
+        }
+        graph.execute(pool);
+
+        //Scannen körs utanför poolen så att nytt minne kan placeras av rätt trådar
+        //när backParticles växer, se memory::Policy::numaFirstTouch
+        {
+            ZoneScopedN("Scan live particles")
+            for(size_t c = 0; c < numberOfChunks; c++){
+                chunkOffsets[c + 1] += chunkOffsets[c];
+                producedRanges[c] = {chunkOffsets[c], chunkOffsets[c + 1]};
+            }
+            numberOfLive = chunkOffsets.back();
+            for(size_t g = 0; g < spawnGroups.size(); g++){
+                producedRanges[numberOfChunks + g] = {numberOfLive + spawnOffsets[spawnGroups[g].first],
+                                                      numberOfLive + spawnOffsets[spawnGroups[g].last]};
+            }
+            const size_t firstBurst = numberOfLive + spawnOffsets.back();
+            for(size_t c = 0; c < numberOfBurstRanges; c++){
+                deathOffsets[c + 1] += deathOffsets[c];
+                burstOffsets[c + 1] += burstOffsets[c];
+                producedRanges[firstBurstRange + c] = {firstBurst + burstOffsets[c], firstBurst + burstOffsets[c + 1]};
+            }
+            deathEvents.resize(deathOffsets.back());
+            numberOfTotal = firstBurst + burstOffsets.back();
+            backParticles.resize(numberOfTotal, Particle({0.0f, 0.0f}, {0.0f, 0.0f}, 0, 0.0f));
+            positionScratch.resize(numberOfTotal);
+            forceScratch.resize(numberOfTotal);
+            if(needsMasses){
+                massScratch.resize(numberOfTotal);
+            }
+            if(out){
+                out->particles.resize(numberOfTotal);
+            }
+        }
+        graph.clear();
+
+        //Ta bort döda partiklar genom att kopiera de levande till backParticles, ordningen behålls
+        for(size_t c = 0; c < numberOfChunks; c++){
+            producers.push_back(graph.add("Compact particles", [&, c](){
+                const size_t last = std::min((c + 1) * ChunkSize, numberOfParticles);
+                size_t to = producedRanges[c].first;
+                size_t event = deathOffsets[c];
+                for(size_t i = c * ChunkSize; i < last; i++){
+                    const Particle& p = particles[i];
+                    if(p.getLifeTime() > 0.0f){
+                        backParticles[to++] = p;
+                    }
+                    else if(useSubEmitters && subEmitterFor(p.getArchetype()) >= 0){
+                        //Samlas tätt packade så att burst-steget kan skapa dem i batchar
+                        deathEvents[event++] = {p.getPosition(), p.getVelocity(), p.getArchetype()};
+                    }
+                }
+                prepare(producedRanges[c].first, producedRanges[c].last);
+            }));
+            preferOwner(producers.back(), producedRanges[c].first);
+        }
+        //Intervallen överlappar inte så emittrarna kan skriva samtidigt utan lås
+        for(size_t g = 0; g < spawnGroups.size(); g++){
+            producers.push_back(graph.add("Spawn particles", [&, g](){
+                for(size_t i = spawnGroups[g].first; i < spawnGroups[g].last; i++){
+                    emitterScratch[i]->emit(backParticles.data() + numberOfLive + spawnOffsets[i],
+                                            numberOfSpawnDirections, angle);
+                }
+                const size_t g0 = numberOfChunks + g;
+                prepare(producedRanges[g0].first, producedRanges[g0].last);
+            }));
+            preferOwner(producers.back(), producedRanges[numberOfChunks + g].first);
+        }
+        //Burstarna från en chunk kan skapas så fort chunken är kompakterad
+        for(size_t c = 0; c < numberOfBurstRanges; c++){
+            const TaskGraph::TaskId compact = producers[c];
+            producers.push_back(graph.add("Spawn bursts", [&, c](){
+                const Range range = producedRanges[firstBurstRange + c];
+                Particle* to = backParticles.data() + range.first;
+                std::uint64_t streamIndex = numberOfBurstParticles + burstOffsets[c];
+                //Döda partiklar i följd med samma sub-emitter skapas i en batch
+                size_t first = deathOffsets[c];
+                while(first < deathOffsets[c + 1]){
+                    const std::int32_t s = subEmitterFor(deathEvents[first].archetype);
+                    size_t last = first + 1;
+                    while(last < deathOffsets[c + 1] && subEmitterFor(deathEvents[last].archetype) == s){
+                        last++;
+                    }
+                    subEmitters[s].spawn(deathEvents.data() + first, last - first, streamIndex, to, burstScratch[c]);
+                    const size_t created = (last - first) * subEmitters[s].getBurstSize();
+                    to += created;
+                    streamIndex += created;
+                    first = last;
+                }
+                prepare(range.first, range.last);
+            }, {compact}));
+            preferOwner(producers.back(), producedRanges[firstBurstRange + c].first);
+        }
+    }
+    if(out){
+        graph.add("Pack emitters and forces", [&](){
+            packEmittersAndForces(*out);
+        });
     }
-        
+
+    //Krafter som bara beror på partikelns egen position, sen integrering och packning per intervall
+    auto addStages = [&](size_t k, const TaskGraph::TaskId* producer){
+        const TaskGraph::TaskId forces = graph.add("Compute forces", [&, k](){
+            const auto [first, last] = producedRanges[k];
+            const vec2* p = positionScratch.data() + first;
+            vec2* f = forceScratch.data() + first;
+            const size_t count = last - first;
+            if(useForceField){
+                //Sampla det förberäknade kraftfältet istället för att gå igenom alla forces
+                forceField.accumulate(p, f, count);
+            }
+            else if(useForceCulling){
+                //Rutnätet har redan räknat alla krafter
+                return;
+            }
+            else{
+                if(!useParticleMesh){
+                    gravityKernel.accumulate(p, f, count);
+                }
+                for(Wind& w: winds){
+                    w.accumulateForces(p, f, count);
+                }
+            }
+        });
+        if(producer){
+            graph.addDependency(*producer, forces);
+        }
+        preferOwner(forces, producedRanges[k].first);
+        const TaskGraph::TaskId integrate = graph.add("Integrate particles", [&, k](){
+            for(size_t i = producedRanges[k].first; i < producedRanges[k].last; i++){
+                const float inverseMass = archetypes[backParticles[i].getArchetype()].inverseMass;
+                backParticles[i].updateSingleParticle(dt, forceScratch[i], inverseMass);
+            }
+        }, {forces});
+        preferOwner(integrate, producedRanges[k].first);
+        if(out){
+            const TaskGraph::TaskId pack = graph.add("Pack particles", [&, k](){
+                packParticles(backParticles, producedRanges[k].first, producedRanges[k].last, *out);
+            }, {integrate});
+            preferOwner(pack, producedRanges[k].first);
+        }
+    };
+
+    if(!useGlobalForces){
+        //Ingen barriär, varje intervall går vidare så fort det är producerat
+        for(size_t k = 0; k < producers.size(); k++){
+            addStages(k, &producers[k]);
+        }
+        graph.execute(ThreadPool::global());
+    }
+    else{
+        graph.execute(ThreadPool::global());
+
+        {
+            ZoneScopedN("Compute global forces")
+            const size_t count = numberOfTotal;
+            if(useParticleMesh){
+                //Partiklarnas massor läggs på ett rutnät, brunnarna har ett eget fält och
+                //vinden beräknas per intervall
+                if(particleMesh.needsUpdate()){
+                    particleMesh.clearMasses();
+                    particleMesh.depositMasses(positionScratch.data(), massScratch.data(), count);
+                }
+                particleMesh.update();
+                particleMesh.accumulate(positionScratch.data(), massScratch.data(), forceScratch.data(),
+                                        count, ThreadPool::global());
+            }
+            else if(useForceCulling){
+                //Bara de krafter som når partikelns cell beräknas
+                forceGrid.accumulate(positionScratch.data(), forceScratch.data(), count);
+            }
+            if(useNBody){
+                //Partiklarna drar i varandra, approximerat med ett Barnes-Hut-träd
+                barnesHutTree.build(positionScratch.data(), massScratch.data(), count);
+                barnesHutTree.accumulate(forceScratch.data(), ThreadPool::global());
+            }
+        }
+
+        graph.clear();
+        for(size_t k = 0; k < producedRanges.size(); k++){
+            addStages(k, nullptr);
+        }
+        graph.execute(ThreadPool::global());
+    }
+    particles.swap(backParticles);
+    numberOfBurstParticles += burstOffsets.back();
+
+    [[maybe_unused]] const size_t particlesSpawned = spawnOffsets.back() + burstOffsets.back();
+    [[maybe_unused]] const size_t particlesKilled = numberOfParticles - numberOfLive;
+    TracyPlot("Spawned particles", int64_t(particlesSpawned));
+    TracyPlot("Killed particles", int64_t(particlesKilled));
+    TracyPlot("Death events", int64_t(deathEvents.size()));
+    TracyPlot("Live particles", int64_t(particles.size()));
 }
 
 void ParticleSystem::render() {
+    ZoneScoped
     // @TODO: Render the particles, emitters and what not contained within the system
-    std::vector<rendering::ParticleInfo> particleInfo;
-    std::vector<rendering::EmitterInfo> emitterInfo;
-    std::vector<rendering::ForceInfo> forceInfo;
-    
-    for(Particle& p: particles){
-        particleInfo.push_back(p.toParticleInfo());
-        
-        /*std::cout << "At render time: Position: (" << p.getPosition().x << ", " << p.getPosition().y << ")"
-                  << " Lifetime: " << p.getLifeTime() << std::endl;*/
-        
+    pack(renderData);
+    draw(renderData);
+}
+
+void ParticleSystem::pack(RenderData& out) {
+    ZoneScopedN("Pack render data")
+    //Återanvänd minnet från förra gången
+    out.particles.resize(particles.size());
+    ThreadPool::global().parallelFor(particles.size(), [&](size_t first, size_t last){
+        packParticles(particles, first, last, out);
+    }, ChunkSize);
+    packEmittersAndForces(out);
+}
+
+void ParticleSystem::packParticles(const memory::LargeVector<Particle>& source, size_t first, size_t last,
+                                   RenderData& out) const {
+    perf::ScopedTimer timer(perf::Phase::Pack);
+    for(size_t i = first; i < last; i++){
+        const Particle& p = source[i];
+        out.particles[i] = p.toParticleInfo(archetypes);
     }
-    for(Emitter* e: emitters){
-        emitterInfo.push_back(e->toEmitterInfo());
+}
+
+void ParticleSystem::packEmittersAndForces(RenderData& out) const {
+    perf::ScopedTimer timer(perf::Phase::Pack);
+    out.emitters.clear();
+    out.forces.clear();
+    for(const Uniform& e: uniforms){
+        out.emitters.push_back(e.toEmitterInfo());
     }
-    for(Force* f: forces){
-        forceInfo.push_back(f->toForceInfo());
+    for(const Directional& e: directionals){
+        out.emitters.push_back(e.toEmitterInfo());
     }
-    
-    rendering::renderParticles(particleInfo);
-    rendering::renderEmitters(emitterInfo);
-    rendering::renderForces(forceInfo);
-    
+    for(const ShapeEmitter& e: shapes){
+        out.emitters.push_back(e.toEmitterInfo());
+    }
+    for(const GravityWell& f: gravityWells){
+        out.forces.push_back(f.toForceInfo());
+    }
+    for(const Wind& f: winds){
+        out.forces.push_back(f.toForceInfo());
+    }
+}
+
+void ParticleSystem::draw(const RenderData& data) {
+    submit(data, rendering::getRenderer(), 0);
 }
 
-void ParticleSystem::addUniform(vec2 inPosition){
+void ParticleSystem::submit(const RenderData& data, rendering::Renderer& renderer, int layer) {
+    renderer.submitParticles(layer, data.particles);
+    renderer.submitEmitters(layer, data.emitters);
+    renderer.submitForces(layer, data.forces);
+}
+
+EmitterHandle ParticleSystem::addUniform(vec2 inPosition){
     Color colorEmitter = {0.2f, 1.0f, 0.8f};
-    Emitter* newUniform = new Uniform(inPosition, 8.0f, colorEmitter);
-    emitters.push_back(newUniform);
+    const Pool<Uniform>::Key key = uniforms.add(inPosition, 8.0f, colorEmitter);
+    Uniform& e = uniforms[key];
+    e.setArchetype(archetypes.add(e.getParticleArchetype()), e.getParticleArchetype());
+    return {EmitterHandle::Type::Uniform, key.index, key.generation};
 }
 
-void ParticleSystem::addDirectional(vec2 inPosition){
+EmitterHandle ParticleSystem::addDirectional(vec2 inPosition){
     Color colorEmitter = {0.8f, 1.0f, 0.2f};
-    Emitter* newDirectional = new Directional(inPosition, 8.0f, colorEmitter, Pi/2);
-    emitters.push_back(newDirectional);
+    const Pool<Directional>::Key key = directionals.add(inPosition, 8.0f, colorEmitter, Pi/2);
+    Directional& e = directionals[key];
+    e.setArchetype(archetypes.add(e.getParticleArchetype()), e.getParticleArchetype());
+    return {EmitterHandle::Type::Directional, key.index, key.generation};
 }
 
-void ParticleSystem::addGravityWell(vec2 inPosition){
+EmitterHandle ParticleSystem::addShape(vec2 inPosition, const EmitterShape& shape){
+    Color colorEmitter = {1.0f, 0.6f, 0.9f};
+    const Pool<ShapeEmitter>::Key key = shapes.add(inPosition, 8.0f, colorEmitter, shape);
+    ShapeEmitter& e = shapes[key];
+    e.setArchetype(archetypes.add(e.getParticleArchetype()), e.getParticleArchetype());
+    const EmitterHandle handle = {EmitterHandle::Type::Shape, key.index, key.generation};
+    //Syfte 3, positionerna får inte bero på jitterströmmen
+    e.setStream(rng::Stream(seed, streamId(handle), 3));
+    return handle;
+}
+
+ForceHandle ParticleSystem::addGravityWell(vec2 inPosition, float radius){
     Color colorForce = {0.2f, 0.5f, 0.9f};
-    Force* newGravityWell = new GravityWell(inPosition, 6.0f, colorForce);
-    forces.push_back(newGravityWell);
+    const Pool<GravityWell>::Key key = gravityWells.add(inPosition, 6.0f, colorForce, gravitySoftening, radius);
+    forcesChanged();
+    return {ForceHandle::Type::GravityWell, key.index, key.generation};
 }
 
-void ParticleSystem::addWind(vec2 inPosition){
+ForceHandle ParticleSystem::addWind(vec2 inPosition, float radius, float angle){
     Color colorForce = {0.9f, 0.5f, 0.2f};
-    Force* newWind = new Wind(inPosition, 6.0f, colorForce, Pi/4);
-    forces.push_back(newWind);
+    const Pool<Wind>::Key key = winds.add(inPosition, 6.0f, colorForce, angle, radius);
+    forcesChanged();
+    return {ForceHandle::Type::Wind, key.index, key.generation};
+}
+
+bool ParticleSystem::removeEmitter(EmitterHandle handle){
+    if(!isValid(handle)){
+        return false;
+    }
+    //Egna arketyper och sub-emitters behövs bara så länge partiklarna lever
+    const Emitter& e = getEmitter(handle);
+    if(!archetypes.isShared(e.getArchetype())){
+        Retired chain;
+        chain.archetypes = e.getColorVariants();
+        chain.archetypes.push_back(e.getArchetype());
+        collectChain(e.getArchetype(), chain);
+        retired.push_back(std::move(chain));
+    }
+    reclaimRetired();
+
+    //Den sista emittern flyttas till den borttagnas plats, emitteringsordningen ändras men inget annat
+    switch(handle.type){
+        case EmitterHandle::Type::Uniform: return uniforms.remove({handle.index, handle.generation});
+        case EmitterHandle::Type::Directional: return directionals.remove({handle.index, handle.generation});
+        case EmitterHandle::Type::Shape: return shapes.remove({handle.index, handle.generation});
+    }
+    return false;
+}
+
+bool ParticleSystem::removeForce(ForceHandle handle){
+    const bool removed = handle.type == ForceHandle::Type::GravityWell ?
+        gravityWells.remove({handle.index, handle.generation}) :
+        winds.remove({handle.index, handle.generation});
+    if(removed){
+        forcesChanged();
+    }
+    return removed;
+}
+
+bool ParticleSystem::isValid(EmitterHandle handle) const{
+    switch(handle.type){
+        case EmitterHandle::Type::Uniform: return uniforms.contains({handle.index, handle.generation});
+        case EmitterHandle::Type::Directional: return directionals.contains({handle.index, handle.generation});
+        case EmitterHandle::Type::Shape: return shapes.contains({handle.index, handle.generation});
+    }
+    return false;
+}
+
+bool ParticleSystem::isValid(ForceHandle handle) const{
+    if(handle.type == ForceHandle::Type::GravityWell){
+        return gravityWells.contains({handle.index, handle.generation});
+    }
+    return winds.contains({handle.index, handle.generation});
+}
+
+Emitter& ParticleSystem::getEmitter(EmitterHandle handle){
+    if(handle.type == EmitterHandle::Type::Uniform){
+        return uniforms[{handle.index, handle.generation}];
+    }
+    if(handle.type == EmitterHandle::Type::Shape){
+        return shapes[{handle.index, handle.generation}];
+    }
+    return directionals[{handle.index, handle.generation}];
+}
+
+Force& ParticleSystem::getForce(ForceHandle handle){
+    if(handle.type == ForceHandle::Type::GravityWell){
+        return gravityWells[{handle.index, handle.generation}];
+    }
+    return winds[{handle.index, handle.generation}];
+}
+
+std::size_t ParticleSystem::getNumberOfEmitters() const{
+    return uniforms.size() + directionals.size() + shapes.size();
+}
+
+std::size_t ParticleSystem::getNumberOfForces() const{
+    return gravityWells.size() + winds.size();
+}
+
+std::size_t ParticleSystem::getNumberOfArchetypes() const{
+    return archetypes.size();
+}
+
+std::size_t ParticleSystem::getNumberOfSubEmitters() const{
+    return subEmitters.size();
+}
+
+void ParticleSystem::clear(){
+    uniforms.clear();
+    directionals.clear();
+    shapes.clear();
+    gravityWells.clear();
+    winds.clear();
+    particles.clear();
+    archetypes.clear();
+    subEmitters.clear();
+    subEmitterOfArchetype.clear();
+    retired.clear();
+    freeSubEmitters.clear();
+    numberOfBurstParticles = 0;
+    forcesChanged();
+}
+
+void ParticleSystem::setSeed(std::uint64_t inSeed){
+    seed = inSeed;
+}
+
+void ParticleSystem::setEmitterJitter(EmitterHandle handle, const EmitterJitter& jitter){
+    const std::uint32_t id = streamId(handle);
+    Emitter& e = getEmitter(handle);
+
+    std::vector<std::uint32_t> colorVariants;
+    if(jitter.color > 0.0f){
+        //Egen ström för färgerna så att de inte beror på partiklarnas slumptal
+        const rng::Stream colorStream(seed, id, 1);
+        const ParticleArchetype base = e.getParticleArchetype();
+        //En emitter med egen arketyp ska inte dela varianterna med andra emittrar. De gamla
+        //varianterna återanvänds när deras partiklar är borta
+        const bool shared = archetypes.isShared(e.getArchetype());
+        if(!shared && !e.getColorVariants().empty()){
+            retired.push_back({e.getColorVariants(), {}});
+            e.setColorVariants({});
+        }
+        reclaimRetired();
+        for(std::uint64_t v = 0; v < NumberOfColorVariants; v++){
+            const std::array<float, 4> r = colorStream.uniform4(v);
+            ParticleArchetype variant = base;
+            variant.color.r = std::clamp(base.color.r + jitter.color * (2.0f * r[0] - 1.0f), 0.0f, 1.0f);
+            variant.color.g = std::clamp(base.color.g + jitter.color * (2.0f * r[1] - 1.0f), 0.0f, 1.0f);
+            variant.color.b = std::clamp(base.color.b + jitter.color * (2.0f * r[2] - 1.0f), 0.0f, 1.0f);
+            colorVariants.push_back(shared ? archetypes.add(variant) : archetypes.addUnique(variant));
+        }
+    }
+    //Färgvarianterna ska ge samma burst som emitterns egen arketyp
+    const std::int32_t s = subEmitterFor(e.getArchetype());
+    if(s >= 0){
+        subEmitterOfArchetype.resize(archetypes.size(), -1);
+        for(std::uint32_t variant: colorVariants){
+            subEmitterOfArchetype[variant] = s;
+        }
+    }
+    e.setJitter(jitter, rng::Stream(seed, id), std::move(colorVariants));
 }
 
-std::vector<Particle> ParticleSystem::getParticles() {
-    return particles;
+std::size_t ParticleSystem::addSubEmitters(EmitterHandle handle, const std::vector<SubEmitterDescription>& stages){
+    Emitter& e = getEmitter(handle);
+    //En tidigare kedja ersätts, den återanvänds när dess partiklar är borta
+    if(!archetypes.isShared(e.getArchetype())){
+        Retired chain;
+        collectChain(e.getArchetype(), chain);
+        retired.push_back(std::move(chain));
+        subEmitterOfArchetype[e.getArchetype()] = -1;
+        for(std::uint32_t variant: e.getColorVariants()){
+            subEmitterOfArchetype[variant] = -1;
+        }
+    }
+    reclaimRetired();
+    //Emittrar med samma inställningar delar arketyp, den här får egna kopior så att
+    //andra emittrars partiklar inte också exploderar
+    if(archetypes.isShared(e.getArchetype())){
+        const ParticleArchetype description = archetypes[e.getArchetype()];
+        e.setArchetype(archetypes.addUnique(description), description);
+        std::vector<std::uint32_t> variants;
+        for(std::uint32_t variant: e.getColorVariants()){
+            variants.push_back(archetypes.addUnique(archetypes[variant]));
+        }
+        e.setColorVariants(std::move(variants));
+    }
+    std::vector<std::uint32_t> triggers = e.getColorVariants();
+    triggers.push_back(e.getArchetype());
+
+    //Kedjans arketyper är egna och kan inte leda tillbaka via indexen. Ett steg som skapar
+    //samma sorts partiklar som ett tidigare är ändå tänkt som en loop som växer utan gräns
+    std::vector<std::uint32_t> chain = triggers;
+    std::size_t added = 0;
+    for(const SubEmitterDescription& stage: stages){
+        if(std::any_of(chain.begin(), chain.end(),
+                       [&](std::uint32_t t){ return isSame(archetypes[t], stage.archetype); })){
+            LOG_WARNING("Sub-emitter stage %zu would trigger itself, the chain stops there", added);
+            break;
+        }
+        const std::uint32_t burstArchetype = archetypes.addUnique(stage.archetype);
+        subEmitterOfArchetype.resize(archetypes.size(), -1);
+        chain.push_back(burstArchetype);
+        //Egen ström per sub-emitter, syfte 2 så att den aldrig krockar med emittrarnas
+        std::int32_t index = static_cast<std::int32_t>(subEmitters.size());
+        if(!freeSubEmitters.empty()){
+            index = freeSubEmitters.back();
+            freeSubEmitters.pop_back();
+        }
+        const SubEmitter subEmitter(stage, burstArchetype, rng::Stream(seed, static_cast<std::uint32_t>(index), 2));
+        if(index == static_cast<std::int32_t>(subEmitters.size())){
+            subEmitters.push_back(subEmitter);
+        }
+        else{
+            subEmitters[index] = subEmitter;
+        }
+        for(std::uint32_t t: triggers){
+            subEmitterOfArchetype[t] = index;
+        }
+        triggers = {burstArchetype};
+        added++;
+    }
+    return added;
+}
+
+std::int32_t ParticleSystem::subEmitterFor(std::uint32_t archetype) const{
+    return archetype < subEmitterOfArchetype.size() ? subEmitterOfArchetype[archetype] : -1;
+}
+
+void ParticleSystem::collectChain(std::uint32_t archetype, Retired& out) const{
+    //Kedjorna av egna arketyper leder aldrig tillbaka, se addSubEmitters
+    for(std::int32_t s = subEmitterFor(archetype); s >= 0; s = subEmitterFor(archetype)){
+        out.stages.push_back(s);
+        archetype = subEmitters[s].getArchetype();
+        out.archetypes.push_back(archetype);
+    }
 }
 
+void ParticleSystem::reclaimRetired(){
+    if(retired.empty()){
+        return;
+    }
+    //Anropas mellan uppdateringar, då finns alla levande partiklar i particles
+    std::vector<bool> used(archetypes.size(), false);
+    for(const Particle& p: particles){
+        used[p.getArchetype()] = true;
+    }
+    auto stillUsed = [&](const Retired& r){
+        return std::any_of(r.archetypes.begin(), r.archetypes.end(), [&](std::uint32_t a){ return used[a]; });
+    };
+    for(const Retired& r: retired){
+        if(stillUsed(r)){
+            continue;
+        }
+        for(std::uint32_t a: r.archetypes){
+            subEmitterOfArchetype[a] = -1;
+            archetypes.release(a);
+        }
+        freeSubEmitters.insert(freeSubEmitters.end(), r.stages.begin(), r.stages.end());
+    }
+    retired.erase(std::remove_if(retired.begin(), retired.end(), [&](const Retired& r){ return !stillUsed(r); }),
+                  retired.end());
+}
+
+void ParticleSystem::forcesChanged(){
+    //Kärnor och rutnät som bygger på krafterna måste göras om
+    std::vector<GravityWell*> wellPointers;
+    for(GravityWell& w: gravityWells){
+        wellPointers.push_back(&w);
+    }
+    gravityKernel.setWells(wellPointers);
+    std::vector<vec2> wellPositions;
+    std::vector<float> wellStrengths;
+    for(const GravityWell& w: gravityWells){
+        wellPositions.push_back(w.getPosition());
+        wellStrengths.push_back(w.getStrength());
+    }
+    particleMesh.setWells(wellPositions.data(), wellStrengths.data(), wellPositions.size());
+    forceField.markDirty();
+    forceGrid.markDirty();
+}
+
+std::vector<Force*> ParticleSystem::collectForces(){
+    std::vector<Force*> forces;
+    for(GravityWell& w: gravityWells){
+        forces.push_back(&w);
+    }
+    for(Wind& w: winds){
+        forces.push_back(&w);
+    }
+    return forces;
+}
+
+ParticleView ParticleSystem::getParticles() const{
+    return ParticleView(particles.data(), particles.size(), &archetypes);
+}
+
+std::vector<Particle> ParticleSystem::snapshotParticles() const{
+    return std::vector<Particle>(particles.begin(), particles.end());
+}
+
+void ParticleSystem::setForceFieldEnabled(bool enabled){
+    forceFieldEnabled = enabled;
+}
+
+bool ParticleSystem::isForceFieldEnabled() const{
+    return forceFieldEnabled;
+}
+
+void ParticleSystem::setForceFieldResolution(int resolution){
+    if(resolution != forceField.getResolution()){
+        forceField.setResolution(resolution);
+    }
+}
+
+void ParticleSystem::setGravitySoftening(float softening){
+    gravitySoftening = softening;
+    for(GravityWell& w: gravityWells){
+        w.setSoftening(softening);
+    }
+    forcesChanged();
+}
+
+void ParticleSystem::setPreciseGravity(bool precise){
+    gravityKernel.setPrecise(precise);
+    forceGrid.markDirty();
+}
+
+void ParticleSystem::setForceCullingEnabled(bool enabled){
+    forceCullingEnabled = enabled;
+}
+
+void ParticleSystem::setNBodyEnabled(bool enabled){
+    nBodyEnabled = enabled;
+}
+
+void ParticleSystem::setNBodyOpeningAngle(float theta){
+    barnesHutTree.setOpeningAngle(theta);
+}
+
+void ParticleSystem::setNBodyGravitationalConstant(float G){
+    barnesHutTree.setGravitationalConstant(G);
+}
+
+void ParticleSystem::setParticleMeshEnabled(bool enabled){
+    particleMeshEnabled = enabled;
+}
+
+void ParticleSystem::setParticleMeshResolution(int cellsPerAxis){
+    if(cellsPerAxis != particleMesh.getCellsPerAxis()){
+        particleMesh.setCellsPerAxis(cellsPerAxis);
+    }
+}
+
+void ParticleSystem::setParticleMeshUpdateInterval(int steps){
+    particleMesh.setUpdateInterval(steps);
+}
 
-/*void ParticleSystem::removeLatestEmitter(){
-    emitters.erase(emitters.end());
-}*/
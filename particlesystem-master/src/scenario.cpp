@@ -0,0 +1,394 @@
+//
+//  scenario.cpp
+//  ParticleSystem
+//
+
+#include "scenario.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    constexpr float Pi = 3.141592654f;
+    constexpr float Extent = 0.9f;
+    //Färgerna på burststegen i tur och ordning, så att stegen syns och får olika arketyper
+    const Color BurstColors[] = {{1.0f, 0.8f, 0.3f}, {1.0f, 0.35f, 0.2f}, {0.5f, 0.8f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+
+    struct Preset {
+        const char* name;
+        const char* text;
+    };
+
+    //Förinställda scenarier, skrivna i samma format som scenariofilerna
+    const Preset Presets[] = {
+        { "small",
+          "name Small: 16 emitters, 4 wells\n"
+          "grid uniform 4 4\n"
+          "ring gravity 4 0.5\n" },
+        { "million",
+          "name 1M particles / 64 wells / 256 emitters\n"
+          "seed 64\n"
+          "duration 60\n"
+          "# 224 * 3600 + 32 * 2 * 3600 particles alive after 60 s at 60 Hz\n"
+          "grid uniform 16 14\n"
+          "ring directional 32 0.95 2\n"
+          "random gravity 64 0.3\n" },
+        { "wind-tunnel",
+          "name Wind tunnel: 64 directional emitters, 128 local winds\n"
+          "angle 0\n"
+          "grid directional 8 8 4\n"
+          "grid wind 16 8 0 0.2\n" },
+        { "nbody",
+          "name N-body cluster: particles attract each other\n"
+          "set nBody on\n"
+          "ring uniform 8 0.6 4\n"
+          "gravity 0 0\n" },
+        { "particle-mesh",
+          "name Particle-mesh gravity: 64 emitters, 64 wells\n"
+          "seed 7\n"
+          "set particleMesh on\n"
+          "grid uniform 8 8 2\n"
+          "random gravity 64\n" },
+        { "shapes",
+          "name Shape emitters: a disc, a ring, a rectangle and a zigzag line\n"
+          "seed 11\n"
+          "disc -0.5 0.5 0.2 16\n"
+          "annulus 0.5 0.5 0.15 0.25 16\n"
+          "rectangle -0.5 -0.5 0.4 0.2 16\n"
+          "polyline 16 0.2 -0.7 0.4 -0.3 0.6 -0.7 0.8 -0.3\n"
+          "gravity 0 0\n" },
+    };
+
+    [[noreturn]] void fail(int line, const std::string& message){
+        throw std::runtime_error("Scenario line " + std::to_string(line) + ": " + message);
+    }
+
+    //Läser ett obligatoriskt värde
+    template <typename T>
+    T read(std::istringstream& words, int line, const char* what){
+        T value;
+        if(!(words >> value)){
+            fail(line, std::string("expected ") + what);
+        }
+        return value;
+    }
+
+    //Läser ett valfritt värde, ger false om raden är slut
+    bool readOptional(std::istringstream& words, int line, float& value){
+        std::string word;
+        if(!(words >> word)){
+            return false;
+        }
+        try{
+            std::size_t used = 0;
+            value = std::stof(word, &used);
+            if(used == word.size()){
+                return true;
+            }
+        }
+        catch(const std::exception&){}
+        fail(line, "expected a number but got '" + word + "'");
+    }
+
+    void expectEnd(std::istringstream& words, int line){
+        words.clear();
+        std::string extra;
+        if(words >> extra){
+            fail(line, "unexpected '" + extra + "'");
+        }
+    }
+
+    bool readSwitch(std::istringstream& words, int line){
+        const std::string value = read<std::string>(words, line, "on or off");
+        if(value == "on"){
+            return true;
+        }
+        if(value == "off"){
+            return false;
+        }
+        fail(line, "expected on or off but got '" + value + "'");
+    }
+
+    //Lägger till ett objekt av typen kind på position, parametrarna beror på typen
+    void addObject(Scenario& scenario, const std::string& kind, vec2 position,
+                   std::istringstream& words, int line, float defaultWindAngle){
+        if(kind == "uniform" || kind == "directional"){
+            Scenario::EmitterDescription e;
+            e.type = kind == "uniform" ? EmitterHandle::Type::Uniform : EmitterHandle::Type::Directional;
+            e.position = position;
+            float rate = 1.0f;
+            readOptional(words, line, rate);
+            e.rate = static_cast<int>(rate);
+            scenario.emitters.push_back(e);
+        }
+        else if(kind == "gravity" || kind == "wind"){
+            Scenario::ForceDescription f;
+            f.type = kind == "gravity" ? ForceHandle::Type::GravityWell : ForceHandle::Type::Wind;
+            f.position = position;
+            if(f.type == ForceHandle::Type::Wind){
+                f.angle = defaultWindAngle;
+                readOptional(words, line, f.angle);
+            }
+            readOptional(words, line, f.radius);
+            scenario.forces.push_back(f);
+        }
+        else{
+            fail(line, "unknown object type '" + kind + "'");
+        }
+        expectEnd(words, line);
+    }
+} // namespace
+
+Scenario parseScenario(std::istream& input){
+    Scenario scenario;
+    std::mt19937 generator(scenario.seed);
+    //mt19937 ger samma talföljd överallt, till skillnad från std::uniform_real_distribution
+    auto random = [&generator](float low, float high){
+        return low + (high - low) * static_cast<float>(generator() >> 8) / 16777216.0f;
+    };
+
+    EmitterJitter jitter;
+    std::vector<SubEmitterDescription> bursts;
+
+    std::string text;
+    int line = 0;
+    while(std::getline(input, text)){
+        line++;
+        const std::size_t emittersBefore = scenario.emitters.size();
+        text = text.substr(0, text.find('#'));
+        std::istringstream words(text);
+        std::string command;
+        if(!(words >> command)){
+            continue;
+        }
+
+        if(command == "name"){
+            std::getline(words >> std::ws, scenario.name);
+            scenario.name.erase(scenario.name.find_last_not_of(" \t\r") + 1);
+            continue;
+        }
+        else if(command == "seed"){
+            scenario.seed = read<std::uint32_t>(words, line, "a seed");
+            generator.seed(scenario.seed);
+        }
+        else if(command == "timestep"){
+            scenario.timestep = read<float>(words, line, "a timestep");
+            if(!(scenario.timestep > 0.0f)){
+                fail(line, "the timestep has to be positive");
+            }
+        }
+        else if(command == "duration"){
+            scenario.duration = read<float>(words, line, "a duration");
+        }
+        else if(command == "spawnDirections"){
+            scenario.numberOfSpawnDirections = read<float>(words, line, "a number of directions");
+        }
+        else if(command == "angle"){
+            scenario.angle = read<float>(words, line, "an angle");
+        }
+        else if(command == "jitter"){
+            jitter.angle = read<float>(words, line, "an angle jitter");
+            jitter.speed = read<float>(words, line, "a speed jitter");
+            jitter.lifetime = read<float>(words, line, "a lifetime jitter");
+            jitter.color = read<float>(words, line, "a color jitter");
+        }
+        else if(command == "burst"){
+            std::string first = read<std::string>(words, line, "a count or off");
+            if(first == "off"){
+                bursts.clear();
+            }
+            else{
+                SubEmitterDescription stage;
+                std::istringstream count(first);
+                stage.count = read<int>(count, line, "a count");
+                expectEnd(count, line);
+                stage.speed = read<float>(words, line, "a speed");
+                stage.inheritVelocity = read<float>(words, line, "an inherited velocity");
+                stage.archetype.lifetime = read<float>(words, line, "a lifetime");
+                stage.archetype.color = BurstColors[bursts.size() % std::size(BurstColors)];
+                if(stage.count < 1 || !(stage.archetype.lifetime > 0.0f)){
+                    fail(line, "a burst needs at least one particle and a positive lifetime");
+                }
+                bursts.push_back(stage);
+            }
+        }
+        else if(command == "set"){
+            const std::string setting = read<std::string>(words, line, "a setting");
+            if(setting == "forceField") scenario.forceField = readSwitch(words, line);
+            else if(setting == "forceCulling") scenario.forceCulling = readSwitch(words, line);
+            else if(setting == "nBody") scenario.nBody = readSwitch(words, line);
+            else if(setting == "particleMesh") scenario.particleMesh = readSwitch(words, line);
+            else if(setting == "preciseGravity") scenario.preciseGravity = readSwitch(words, line);
+            else if(setting == "gravitySoftening") scenario.gravitySoftening = read<float>(words, line, "a softening");
+            else fail(line, "unknown setting '" + setting + "'");
+        }
+        else if(command == "uniform" || command == "directional" || command == "gravity" || command == "wind"){
+            const float x = read<float>(words, line, "an x coordinate");
+            const float y = read<float>(words, line, "a y coordinate");
+            addObject(scenario, command, {x, y}, words, line, Pi/4);
+        }
+        else if(command == "line" || command == "disc" || command == "annulus" || command == "rectangle"){
+            //Formen ligger runt emitterns position, för linjen mittpunkten
+            Scenario::EmitterDescription e;
+            e.type = EmitterHandle::Type::Shape;
+            e.position = {read<float>(words, line, "an x coordinate"), read<float>(words, line, "a y coordinate")};
+            if(command == "line"){
+                const vec2 to = {read<float>(words, line, "an x coordinate"), read<float>(words, line, "a y coordinate")};
+                const vec2 middle = (e.position + to)*0.5f;
+                e.shape = EmitterShape::line(e.position - middle, to - middle);
+                e.position = middle;
+            }
+            else if(command == "disc"){
+                e.shape = EmitterShape::disc(read<float>(words, line, "a radius"));
+            }
+            else if(command == "annulus"){
+                const float inner = read<float>(words, line, "an inner radius");
+                e.shape = EmitterShape::annulus(inner, read<float>(words, line, "an outer radius"));
+            }
+            else{
+                const float width = read<float>(words, line, "a width");
+                e.shape = EmitterShape::rectangle(vec2(width, read<float>(words, line, "a height"))*0.5f);
+            }
+            if(!(e.shape.outerRadius > 0.0f) || e.shape.innerRadius < 0.0f || e.shape.innerRadius > e.shape.outerRadius){
+                fail(line, "the radii have to satisfy 0 <= inner <= outer and outer > 0");
+            }
+            float rate = 1.0f;
+            readOptional(words, line, rate);
+            e.rate = static_cast<int>(rate);
+            scenario.emitters.push_back(e);
+        }
+        else if(command == "polyline"){
+            Scenario::EmitterDescription e;
+            e.type = EmitterHandle::Type::Shape;
+            e.position = {0.0f, 0.0f};
+            e.rate = read<int>(words, line, "a rate");
+            std::vector<vec2> points;
+            float x;
+            while(readOptional(words, line, x)){
+                points.push_back({x, read<float>(words, line, "a y coordinate")});
+            }
+            if(points.size() < 2){
+                fail(line, "a polyline needs at least two points");
+            }
+            e.shape = EmitterShape::polyline(std::move(points));
+            scenario.emitters.push_back(e);
+        }
+        else if(command == "random"){
+            const std::string kind = read<std::string>(words, line, "an object type");
+            const int count = read<int>(words, line, "a count");
+            std::string parameters;
+            std::getline(words, parameters);
+            for(int i = 0; i < count; i++){
+                const vec2 position = {random(-Extent, Extent), random(-Extent, Extent)};
+                const float windAngle = random(0.0f, 2*Pi);
+                std::istringstream objectParameters(parameters);
+                addObject(scenario, kind, position, objectParameters, line, windAngle);
+            }
+        }
+        else if(command == "ring"){
+            const std::string kind = read<std::string>(words, line, "an object type");
+            const int count = read<int>(words, line, "a count");
+            const float ringRadius = read<float>(words, line, "a ring radius");
+            std::string parameters;
+            std::getline(words, parameters);
+            for(int i = 0; i < count; i++){
+                const float theta = 2*Pi*i/count;
+                //Vindar blåser längs ringen om ingen vinkel anges
+                std::istringstream objectParameters(parameters);
+                addObject(scenario, kind, {ringRadius*std::cos(theta), ringRadius*std::sin(theta)},
+                          objectParameters, line, theta + Pi/2);
+            }
+        }
+        else if(command == "grid"){
+            const std::string kind = read<std::string>(words, line, "an object type");
+            const int columns = read<int>(words, line, "a number of columns");
+            const int rows = read<int>(words, line, "a number of rows");
+            std::string parameters;
+            std::getline(words, parameters);
+            for(int j = 0; j < rows; j++){
+                for(int i = 0; i < columns; i++){
+                    const vec2 position = {-Extent + 2*Extent*(i + 0.5f)/columns,
+                                           -Extent + 2*Extent*(j + 0.5f)/rows};
+                    std::istringstream objectParameters(parameters);
+                    addObject(scenario, kind, position, objectParameters, line, Pi/4);
+                }
+            }
+        }
+        else{
+            fail(line, "unknown command '" + command + "'");
+        }
+
+        expectEnd(words, line);
+        for(std::size_t i = emittersBefore; i < scenario.emitters.size(); i++){
+            scenario.emitters[i].jitter = jitter;
+            scenario.emitters[i].bursts = bursts;
+        }
+    }
+    return scenario;
+}
+
+Scenario loadScenario(const std::string& path){
+    std::ifstream file(path);
+    if(!file){
+        throw std::runtime_error("Could not open scenario file '" + path + "'");
+    }
+    Scenario scenario = parseScenario(file);
+    if(scenario.name.empty()){
+        scenario.name = path;
+    }
+    return scenario;
+}
+
+std::vector<std::string> getScenarioPresets(){
+    std::vector<std::string> names;
+    for(const Preset& p: Presets){
+        names.push_back(p.name);
+    }
+    return names;
+}
+
+Scenario getScenarioPreset(const std::string& name){
+    for(const Preset& p: Presets){
+        if(name == p.name){
+            std::istringstream text(p.text);
+            return parseScenario(text);
+        }
+    }
+    throw std::runtime_error("Unknown scenario preset '" + name + "'");
+}
+
+void applyScenario(const Scenario& scenario, ParticleSystem& system){
+    system.clear();
+    system.setSeed(scenario.seed);
+    system.setForceFieldEnabled(scenario.forceField);
+    system.setForceCullingEnabled(scenario.forceCulling);
+    system.setNBodyEnabled(scenario.nBody);
+    system.setParticleMeshEnabled(scenario.particleMesh);
+    system.setPreciseGravity(scenario.preciseGravity);
+    system.setGravitySoftening(scenario.gravitySoftening);
+
+    for(const Scenario::EmitterDescription& e: scenario.emitters){
+        const EmitterHandle handle = e.type == EmitterHandle::Type::Uniform ? system.addUniform(e.position) :
+                                     e.type == EmitterHandle::Type::Shape ? system.addShape(e.position, e.shape) :
+                                     system.addDirectional(e.position);
+        system.getEmitter(handle).setSpawnRate(e.rate);
+        if(e.jitter.isActive()){
+            system.setEmitterJitter(handle, e.jitter);
+        }
+        if(!e.bursts.empty()){
+            system.addSubEmitters(handle, e.bursts);
+        }
+    }
+    for(const Scenario::ForceDescription& f: scenario.forces){
+        if(f.type == ForceHandle::Type::GravityWell){
+            system.addGravityWell(f.position, f.radius);
+        }
+        else{
+            system.addWind(f.position, f.radius, f.angle);
+        }
+    }
+}
@@ -0,0 +1,216 @@
+//
+//  shapeEmitter.cpp
+//  ParticleSystem
+//
+
+#include "shapeEmitter.hpp"
+#include "util/vec2xN.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+    constexpr float Pi = 3.141592654f;
+} // namespace
+
+EmitterShape EmitterShape::line(vec2 from, vec2 to){
+    EmitterShape shape;
+    shape.type = Type::Line;
+    shape.points = {from, to};
+    return shape;
+}
+
+EmitterShape EmitterShape::disc(float radius){
+    EmitterShape shape;
+    shape.type = Type::Disc;
+    shape.outerRadius = radius;
+    return shape;
+}
+
+EmitterShape EmitterShape::annulus(float innerRadius, float outerRadius){
+    EmitterShape shape;
+    shape.type = Type::Annulus;
+    shape.innerRadius = innerRadius;
+    shape.outerRadius = outerRadius;
+    return shape;
+}
+
+EmitterShape EmitterShape::rectangle(vec2 halfSize){
+    EmitterShape shape;
+    shape.type = Type::Rectangle;
+    shape.halfSize = halfSize;
+    return shape;
+}
+
+EmitterShape EmitterShape::polyline(std::vector<vec2> points){
+    assert(points.size() >= 2);
+    EmitterShape shape;
+    shape.type = Type::Polyline;
+    shape.points = std::move(points);
+    return shape;
+}
+
+ShapeEmitter::ShapeEmitter(vec2 inPosition, float inSize, Color inColor, const EmitterShape& inShape): Emitter(inPosition, inSize, inColor){
+    shape = inShape;
+    //Egen ström även utan ParticleSystem, syfte 3 krockar inte med jitterströmmarna
+    stream = rng::Stream(0, 0, 3);
+    buildTables();
+}
+
+ParticleArchetype ShapeEmitter::getParticleArchetype() const{
+    float radius = 2.5f;
+    float mass = 0.1f;
+    return {radius, color, 1.0f/mass, 60.0f};
+}
+
+const EmitterShape& ShapeEmitter::getShape() const{
+    return shape;
+}
+
+void ShapeEmitter::setSpeed(float inSpeed){
+    speed = inSpeed;
+}
+
+void ShapeEmitter::setDirectionalAngle(bool enabled){
+    directionalAngle = enabled;
+}
+
+void ShapeEmitter::setStream(const rng::Stream& inStream){
+    stream = inStream;
+    numberOfSampled = 0;
+}
+
+void ShapeEmitter::buildTables(){
+    if(shape.type == EmitterShape::Type::Line || shape.type == EmitterShape::Type::Polyline){
+        //Normalen åt vänster om segmentet, och längden som vikt
+        const std::size_t numberOfSegments = shape.points.size() - 1;
+        std::vector<float> lengths(numberOfSegments);
+        float totalLength = 0.0f;
+        for(std::size_t k = 0; k < numberOfSegments; k++){
+            const vec2 along = shape.points[k + 1] - shape.points[k];
+            lengths[k] = along.length();
+            totalLength += lengths[k];
+            segmentNormals.push_back(lengths[k] > 0.0f ? vec2(-along.y, along.x)/lengths[k] : vec2(0.0f, 1.0f));
+        }
+
+        //Aliastabell (Vose): varje kolumn har sannolikhet 1/n och delas mellan två segment
+        aliasProbability.assign(numberOfSegments, 1.0f);
+        alias.resize(numberOfSegments);
+        std::vector<float> scaled(numberOfSegments);
+        std::vector<std::uint32_t> small, large;
+        for(std::size_t k = 0; k < numberOfSegments; k++){
+            alias[k] = static_cast<std::uint32_t>(k);
+            //Bara punkter utan längd, alla segment lika sannolika
+            scaled[k] = totalLength > 0.0f ? lengths[k]*numberOfSegments/totalLength : 1.0f;
+            (scaled[k] < 1.0f ? small : large).push_back(static_cast<std::uint32_t>(k));
+        }
+        while(!small.empty() && !large.empty()){
+            const std::uint32_t s = small.back();
+            const std::uint32_t l = large.back();
+            small.pop_back();
+            large.pop_back();
+            aliasProbability[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0f;
+            (scaled[l] < 1.0f ? small : large).push_back(l);
+        }
+        //Det som är kvar är 1 upp till avrundningsfel
+    }
+    else if(shape.type == EmitterShape::Type::Disc || shape.type == EmitterShape::Type::Annulus){
+        for(int k = 0; k < DirectionTableSize; k++){
+            const float angle = 2.0f*Pi*k/DirectionTableSize;
+            directions.push_back({std::cos(angle), std::sin(angle)});
+        }
+    }
+}
+
+void ShapeEmitter::emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle){
+    const std::size_t count = getSpawnCount();
+
+    //Fyra slumptal per partikel för hela uppdateringen på en gång
+    randomScratch.resize(4*count);
+    float* const random[4] = {randomScratch.data(), randomScratch.data() + count,
+                              randomScratch.data() + 2*count, randomScratch.data() + 3*count};
+    stream.uniformBatch(numberOfSampled, count, random);
+    numberOfSampled += count;
+
+    //Positioner och riktningar samplas kolumnvis, sen skrivs partiklarna i ett svep
+    positionX.resize(count);
+    positionY.resize(count);
+    directionX.resize(count);
+    directionY.resize(count);
+
+    switch(shape.type){
+        case EmitterShape::Type::Line:
+        case EmitterShape::Type::Polyline: {
+            const std::size_t numberOfSegments = segmentNormals.size();
+            for(std::size_t i = 0; i < count; i++){
+                //Ett slumptal väljer både kolumn och vilken av kolumnens två segment
+                const float column = random[0][i]*numberOfSegments;
+                const std::size_t k = std::min(static_cast<std::size_t>(column), numberOfSegments - 1);
+                const std::size_t segment = column - k < aliasProbability[k] ? k : alias[k];
+                const vec2 from = shape.points[segment];
+                const vec2 to = shape.points[segment + 1];
+                positionX[i] = from.x + random[1][i]*(to.x - from.x);
+                positionY[i] = from.y + random[1][i]*(to.y - from.y);
+                directionX[i] = segmentNormals[segment].x;
+                directionY[i] = segmentNormals[segment].y;
+            }
+            break;
+        }
+        case EmitterShape::Type::Rectangle: {
+            for(std::size_t i = 0; i < count; i++){
+                positionX[i] = (2.0f*random[0][i] - 1.0f)*shape.halfSize.x;
+                positionY[i] = (2.0f*random[1][i] - 1.0f)*shape.halfSize.y;
+                const float length = std::sqrt(positionX[i]*positionX[i] + positionY[i]*positionY[i]);
+                directionX[i] = length > 0.0f ? positionX[i]/length : 1.0f;
+                directionY[i] = length > 0.0f ? positionY[i]/length : 0.0f;
+            }
+            break;
+        }
+        case EmitterShape::Type::Disc:
+        case EmitterShape::Type::Annulus: {
+            //Arean innanför radien r växer som r^2, inversen av dess CDF ger radien
+            const float inner = shape.type == EmitterShape::Type::Disc ? 0.0f : shape.innerRadius;
+            const float innerSquared = inner*inner;
+            const float areaScale = shape.outerRadius*shape.outerRadius - innerSquared;
+            constexpr std::size_t Width = simd::NativeWidth;
+            std::size_t i = 0;
+            for(; i + Width <= count; i += Width){
+                const simd::floatv u = simd::floatv::load(random[0] + i);
+                simd::sqrt(innerSquared + u*areaScale).store(positionX.data() + i);
+            }
+            for(; i < count; i++){
+                positionX[i] = std::sqrt(innerSquared + random[0][i]*areaScale);
+            }
+
+            //Närmaste riktning i tabellen, vriden resten av steget med en förstagradsterm
+            const float step = 2.0f*Pi/DirectionTableSize;
+            for(std::size_t j = 0; j < count; j++){
+                const float table = random[1][j]*DirectionTableSize;
+                const int k = std::min(static_cast<int>(table), DirectionTableSize - 1);
+                const float turn = (table - k)*step;
+                const vec2 d = directions[k];
+                const vec2 direction = {d.x - d.y*turn, d.y + d.x*turn};
+                const float radius = positionX[j];
+                positionX[j] = direction.x*radius;
+                positionY[j] = direction.y*radius;
+                directionX[j] = direction.x;
+                directionY[j] = direction.y;
+            }
+            break;
+        }
+    }
+
+    if(directionalAngle){
+        //Samma riktning för alla, som för en directional emitter
+        std::fill(directionX.begin(), directionX.end(), std::cos(inAngle));
+        std::fill(directionY.begin(), directionY.end(), std::sin(inAngle));
+    }
+
+    for(std::size_t i = 0; i < count; i++){
+        //Skriv partikeln direkt på sin plats i utdata
+        out[i] = Particle(position + vec2(positionX[i], positionY[i]),
+                          vec2(directionX[i], directionY[i])*speed, archetype, particleLifetime);
+    }
+}
@@ -0,0 +1,56 @@
+//
+//  subEmitter.cpp
+//  ParticleSystem
+//
+
+#include "subEmitter.hpp"
+#include <algorithm>
+#include <cmath>
+
+SubEmitter::SubEmitter(const SubEmitterDescription& inDescription, std::uint32_t inArchetype, const rng::Stream& inStream){
+    description = inDescription;
+    description.count = std::max(description.count, 1);
+    archetype = inArchetype;
+    stream = inStream;
+
+    //Samma tabell som för en uniform emitter, inga sin/cos när partiklarna skapas
+    const float step = 2.0f*3.141592654f/description.count;
+    for(int k = 0; k < description.count; k++){
+        velocities.push_back(vec2(std::cos(k*step), std::sin(k*step))*description.speed);
+    }
+}
+
+std::size_t SubEmitter::getBurstSize() const{
+    return velocities.size();
+}
+
+std::uint32_t SubEmitter::getArchetype() const{
+    return archetype;
+}
+
+void SubEmitter::spawn(const DeathEvent* events, std::size_t numberOfEvents, std::uint64_t firstParticle,
+                       Particle* out, std::vector<float>& scratch) const{
+    const std::size_t burstSize = velocities.size();
+    const float lifetime = description.archetype.lifetime;
+    const float inherit = description.inheritVelocity;
+
+    //Alla slumptal för batchen på en gång, ett per partikel så att alla fyra i varje element används
+    const float* speedRandom = nullptr;
+    if(description.speedJitter != 0.0f){
+        const std::size_t count = numberOfEvents*burstSize;
+        scratch.resize(count);
+        stream.uniformSequence(firstParticle, count, scratch.data());
+        speedRandom = scratch.data();
+    }
+
+    for(std::size_t e = 0; e < numberOfEvents; e++){
+        const vec2 position = events[e].position;
+        const vec2 inherited = events[e].velocity*inherit;
+        Particle* burst = out + e*burstSize;
+        for(std::size_t k = 0; k < burstSize; k++){
+            //Från [0, 1) till [-1, 1)
+            const float speedScale = speedRandom ? 1.0f + description.speedJitter*(2.0f*speedRandom[e*burstSize + k] - 1.0f) : 1.0f;
+            burst[k] = Particle(position, inherited + velocities[k]*speedScale, archetype, lifetime);
+        }
+    }
+}
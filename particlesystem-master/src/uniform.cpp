@@ -6,28 +6,71 @@
 //
 
 #include "uniform.hpp"
-//#include
+#include <algorithm>
 
-std::vector<Particle> Uniform::createParticles(float numberOfSpawnDirections, float inAngle){
-    float nOfSpawnDirections = numberOfSpawnDirections;
-    std::vector<Particle> createdParticles;
-    float radius = 3.0f; //Ev flytta ut, så att access finns utifrån
+namespace {
+    constexpr float Speed = 0.3f;               //Storleken på starthastigheten
+    constexpr int NormalizationInterval = 64;   //Rotationer mellan varje renormalisering
+} // namespace
+
+ParticleArchetype Uniform::getParticleArchetype() const{
+    float radius = 3.0f;
     float mass = 0.05f;
-    
-    float m = 0.3f; //storleken på starthasigheten
-    float x,y;
-    
-    //for(int i = 0; i < numberOfParticles; i++){
-        theta = (float)(theta + 2.0f*M_PI/nOfSpawnDirections);
-        x = m*cos(theta);
-        y = m*sin(theta);
-        //Skapa en partikel
-        Particle newParticle = Particle(position, radius, color, mass, {x,y});
-        
-        //Lägga till partikel till createdParticles
-        createdParticles.push_back(newParticle); //bäst att använda push_back eller back_inserter?
-        
-    //}
-    
-    return createdParticles;
+    return {radius, color, 1.0f/mass, 60.0f};
+}
+
+void Uniform::setSpawnDirections(float numberOfSpawnDirections){
+    spawnDirections = numberOfSpawnDirections;
+    //Färre än en riktning skulle ge ett steg större än ett varv
+    const float count = std::max(numberOfSpawnDirections, 1.0f);
+    const float stepAngle = (float)(2.0f*M_PI/count);
+
+    directionTable.clear();
+    if(count == std::floor(count) && count <= MaxTableSize){
+        //Tabellen börjar ett steg efter nuvarande riktning så att ringen fortsätter där den var
+        const float startAngle = std::atan2(direction.y, direction.x);
+        const int n = static_cast<int>(count);
+        directionTable.reserve(n);
+        for(int k = 1; k <= n; k++){
+            directionTable.push_back({std::cos(startAngle + k*stepAngle), std::sin(startAngle + k*stepAngle)});
+        }
+        tableIndex = 0;
+    }
+    else{
+        step = {std::cos(stepAngle), std::sin(stepAngle)};
+    }
+}
+
+void Uniform::emitParticles(Particle* out, float numberOfSpawnDirections, float inAngle){
+    if(numberOfSpawnDirections != spawnDirections){
+        setSpawnDirections(numberOfSpawnDirections);
+    }
+
+    if(!directionTable.empty()){
+        //Hela ringen ligger i tabellen, kopiera en sammanhängande bit i taget
+        const std::size_t n = directionTable.size();
+        int i = 0;
+        while(i < particlesPerUpdate){
+            const int run = static_cast<int>(std::min<std::size_t>(n - tableIndex, particlesPerUpdate - i));
+            for(int k = 0; k < run; k++){
+                //Skriv partikeln direkt på sin plats i utdata
+                out[i + k] = Particle(position, directionTable[tableIndex + k]*Speed, archetype, particleLifetime);
+            }
+            i += run;
+            tableIndex = (tableIndex + run) % n;
+        }
+        direction = directionTable[(tableIndex + n - 1) % n];
+        return;
+    }
+
+    for(int i = 0; i < particlesPerUpdate; i++){
+        //Rotera med (cos, sin) av steget, samma sak som att öka vinkeln
+        direction = {direction.x*step.x - direction.y*step.y, direction.x*step.y + direction.y*step.x};
+        if(++stepsSinceNormalization == NormalizationInterval){
+            //Avrundningsfel får längden att glida, ett Newton-steg mot 1 räcker utan sqrt
+            direction *= 0.5f*(3.0f - (direction.x*direction.x + direction.y*direction.y));
+            stepsSinceNormalization = 0;
+        }
+        out[i] = Particle(position, direction*Speed, archetype, particleLifetime);
+    }
 };
@@ -0,0 +1,286 @@
+#include "util/log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using logging::Argument;
+    using logging::Level;
+
+    struct Record {
+        Level level;
+        std::uint8_t count;
+        const char* format;
+        Clock::time_point time;
+        Argument arguments[logging::MaxArguments];
+        // The whole message if it was formatted by the caller, see makeArgument
+        std::unique_ptr<std::string> text;
+    };
+
+    // Single producer, single consumer: only the owning thread advances tail and only the
+    // thread holding the drain mutex advances head
+    struct Ring {
+        static constexpr std::uint64_t Capacity = 1024;
+
+        std::array<Record, Capacity> records;
+        std::atomic<std::uint64_t> head = 0;
+        std::atomic<std::uint64_t> tail = 0;
+    };
+
+    const char* levelName(Level level) {
+        switch (level) {
+            case Level::Debug: return "DEBUG";
+            case Level::Info: return "INFO ";
+            case Level::Warning: return "WARN ";
+            case Level::Error: return "ERROR";
+            default: return "     ";
+        }
+    }
+
+    bool isOneOf(char c, const char* characters) {
+        return c != '\0' && std::strchr(characters, c) != nullptr;
+    }
+
+    // Formats one conversion. \p spec holds the flags, width and precision without length
+    // modifiers, the conversion character is appended here to match the stored type
+    void formatArgument(std::string& out, std::string spec, char conversion, const Argument& a) {
+        char buffer[128];
+        if (conversion == 's') {
+            spec += 's';
+            if (a.type == Argument::Type::LongString) {
+                // Does not fit the buffer, so measure first
+                const char* value = static_cast<const char*>(a.p);
+                const int length = std::snprintf(nullptr, 0, spec.c_str(), value);
+                std::string formatted(static_cast<std::size_t>(std::max(length, 0)), '\0');
+                std::snprintf(&formatted[0], formatted.size() + 1, spec.c_str(), value);
+                out += formatted;
+                return;
+            }
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), a.type == Argument::Type::String ? a.s : "?");
+        }
+        else if (conversion == 'p') {
+            spec += 'p';
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), a.type == Argument::Type::Pointer ? a.p : nullptr);
+        }
+        else if (isOneOf(conversion, "eEfFgGaA")) {
+            double value = a.d;
+            if (a.type == Argument::Type::Signed) value = static_cast<double>(a.i);
+            if (a.type == Argument::Type::Unsigned) value = static_cast<double>(a.u);
+            spec += conversion;
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+        }
+        else {
+            long long value = a.i;
+            if (a.type == Argument::Type::Double) value = static_cast<long long>(a.d);
+            if (a.type == Argument::Type::Pointer || a.type == Argument::Type::String ||
+                a.type == Argument::Type::LongString) value = 0;
+            spec += "ll";
+            spec += (conversion == 'c') ? 'd' : conversion;
+            if (isOneOf(conversion, "ouxX")) {
+                std::snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned long long>(value));
+            }
+            else {
+                std::snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+            }
+        }
+        out += buffer;
+    }
+
+    class Logger {
+    public:
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                stopping = true;
+            }
+            wakeUp.notify_all();
+            if (drainThread.joinable()) {
+                drainThread.join();
+            }
+            drain();
+        }
+
+        Ring& localRing() {
+            thread_local std::shared_ptr<Ring> ring;
+            if (!ring) {
+                ring = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> lock(registryMutex);
+                rings.push_back(ring);
+                if (!drainThread.joinable()) {
+                    drainThread = std::thread(&Logger::run, this);
+                }
+            }
+            return *ring;
+        }
+
+        void drain() {
+            std::lock_guard<std::mutex> drainLock(drainMutex);
+            std::vector<std::shared_ptr<Ring>> current;
+            {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                current = rings;
+            }
+            for (const std::shared_ptr<Ring>& ring : current) {
+                std::uint64_t head = ring->head.load(std::memory_order_relaxed);
+                const std::uint64_t tail = ring->tail.load(std::memory_order_acquire);
+                for (; head != tail; head++) {
+                    Record& record = ring->records[head % Ring::Capacity];
+                    const std::chrono::duration<double> time = record.time - start;
+                    const std::string message = record.text ? std::move(*record.text)
+                                                            : logging::detail::format(record.format, record.arguments, record.count);
+                    record.text.reset();
+                    if (sink) {
+                        sink(record.level, message);
+                    }
+                    else {
+                        std::fprintf(stderr, "[%10.4f] %s %s\n", time.count(), levelName(record.level), message.c_str());
+                    }
+                    ring->head.store(head + 1, std::memory_order_release);
+                }
+            }
+            std::fflush(stderr);
+        }
+
+        void setSink(logging::Sink newSink) {
+            std::lock_guard<std::mutex> drainLock(drainMutex);
+            sink = std::move(newSink);
+        }
+
+        std::atomic<Level> level = Level::Info;
+        std::atomic<std::uint64_t> dropped = 0;
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (!stopping) {
+                lock.unlock();
+                drain();
+                lock.lock();
+                wakeUp.wait_for(lock, std::chrono::milliseconds(10), [this]() { return stopping; });
+            }
+        }
+
+        const Clock::time_point start = Clock::now();
+
+        std::mutex registryMutex;
+        std::vector<std::shared_ptr<Ring>> rings;
+
+        std::mutex drainMutex;
+        logging::Sink sink;    // Only used while holding the drain mutex
+        std::thread drainThread;
+        std::mutex wakeMutex;
+        std::condition_variable wakeUp;
+        bool stopping = false;
+    };
+
+    Logger& logger() {
+        static Logger instance;
+        return instance;
+    }
+} // namespace
+
+namespace logging {
+
+void setLevel(Level level) {
+    logger().level = level;
+}
+
+Level getLevel() {
+    return logger().level;
+}
+
+bool isEnabled(Level level) {
+    return level >= logger().level.load(std::memory_order_relaxed) && level != Level::None;
+}
+
+void flush() {
+    logger().drain();
+}
+
+std::uint64_t getNumberOfDroppedMessages() {
+    return logger().dropped;
+}
+
+void setSink(Sink sink) {
+    logger().setSink(std::move(sink));
+}
+
+namespace detail {
+
+void push(Level level, const char* message, const Argument* arguments, std::size_t count) {
+    Logger& l = logger();
+    Ring& ring = l.localRing();
+
+    const std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) >= Ring::Capacity) {
+        l.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record& record = ring.records[tail % Ring::Capacity];
+    record.level = level;
+    record.format = message;
+    record.time = Clock::now();
+    // A long string only lives until the caller returns, so its message is formatted now
+    const bool hasLongString = std::any_of(arguments, arguments + count, [](const Argument& a) {
+        return a.type == Argument::Type::LongString;
+    });
+    if (hasLongString) {
+        record.text = std::make_unique<std::string>(format(message, arguments, count));
+        record.count = 0;
+    }
+    else {
+        record.count = static_cast<std::uint8_t>(count);
+        for (std::size_t i = 0; i < count; i++) {
+            record.arguments[i] = arguments[i];
+        }
+    }
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+std::string format(const char* message, const Argument* arguments, std::size_t count) {
+    std::string out;
+    std::size_t next = 0;
+    for (const char* c = message; *c != '\0'; c++) {
+        if (*c != '%') {
+            out += *c;
+            continue;
+        }
+        if (c[1] == '%') {
+            out += '%';
+            c++;
+            continue;
+        }
+        std::string spec = "%";
+        const char* d = c + 1;
+        while (isOneOf(*d, "-+ #0123456789.")) {
+            spec += *d++;
+        }
+        while (isOneOf(*d, "hlLqjzt")) {
+            d++;
+        }
+        if (*d == '\0' || next >= count) {
+            // Malformed or missing argument, print the conversion as written
+            out.append(c, d - c + (*d != '\0' ? 1 : 0));
+        }
+        else {
+            formatArgument(out, spec, *d, arguments[next++]);
+        }
+        c = *d != '\0' ? d : d - 1;
+    }
+    return out;
+}
+
+} // namespace detail
+
+} // namespace logging
@@ -0,0 +1,131 @@
+#include "util/memory.h"
+
+#include "util/threadpool.h"
+#include "Tracy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr std::size_t HugePageSize = std::size_t(2) << 20;
+
+    std::atomic<bool> hugePagesEnabled = true;
+    std::atomic<bool> numaFirstTouchEnabled = false;
+
+#ifdef __linux__
+    // Large mappings are always rounded up to whole huge pages, so deallocate can compute
+    // the mapped length without knowing whether huge pages were actually used
+    std::size_t mappedLength(std::size_t bytes) {
+        return (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+    }
+#endif
+
+    // Every page is touched by the owner of the chunk that its first byte belongs to
+    void touchPages(void* pointer, std::size_t bytes, std::size_t elementSize) {
+        const std::size_t pageSize = memory::pageSize();
+        char* base = static_cast<char*>(pointer);
+        const std::size_t chunkBytes = memory::chunkSize * elementSize;
+        const std::size_t numberOfChunks = (bytes + chunkBytes - 1) / chunkBytes;
+        ThreadPool& pool = ThreadPool::global();
+        const unsigned numberOfThreads = pool.getNumberOfThreads();
+        pool.run([&](unsigned threadIndex) {
+            ZoneScopedN("First touch")
+            for (std::size_t c = 0; c < numberOfChunks; c++) {
+                if (ThreadPool::chunkOwner(c, numberOfThreads) != threadIndex) {
+                    continue;
+                }
+                const std::size_t firstPage = (c * chunkBytes + pageSize - 1) / pageSize;
+                const std::size_t lastPage = (std::min((c + 1) * chunkBytes, bytes) + pageSize - 1) / pageSize;
+                for (std::size_t page = firstPage; page < lastPage; page++) {
+                    base[page * pageSize] = 0;
+                }
+            }
+        });
+    }
+} // namespace
+
+namespace memory {
+
+std::size_t pageSize() {
+#ifdef __linux__
+    static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+void setPolicy(const Policy& policy) {
+    hugePagesEnabled = policy.hugePages;
+    numaFirstTouchEnabled = policy.numaFirstTouch;
+}
+
+Policy getPolicy() {
+    Policy policy;
+    policy.hugePages = hugePagesEnabled;
+    policy.numaFirstTouch = numaFirstTouchEnabled;
+    return policy;
+}
+
+void* allocate(std::size_t bytes, std::size_t elementSize) {
+    if (bytes < largeAllocationThreshold) {
+        void* pointer = ::operator new(bytes);
+        TracyAlloc(pointer, bytes)
+        return pointer;
+    }
+
+#ifdef __linux__
+    const std::size_t length = mappedLength(bytes);
+    void* pointer = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (hugePagesEnabled) {
+        // Only succeeds if the administrator has reserved huge pages
+        pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (pointer == MAP_FAILED) {
+        pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pointer == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugePagesEnabled) {
+            madvise(pointer, length, MADV_HUGEPAGE);
+        }
+#endif
+    }
+#else
+    void* pointer = ::operator new(bytes, std::align_val_t(HugePageSize));
+#endif
+
+    // A huge page would be placed by the first of its owners, see memory::Policy
+    if (numaFirstTouchEnabled && !hugePagesEnabled) {
+        touchPages(pointer, bytes, elementSize);
+    }
+    TracyAlloc(pointer, bytes)
+    return pointer;
+}
+
+void deallocate(void* pointer, std::size_t bytes) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    TracyFree(pointer)
+    if (bytes < largeAllocationThreshold) {
+        ::operator delete(pointer);
+        return;
+    }
+#ifdef __linux__
+    munmap(pointer, mappedLength(bytes));
+#else
+    ::operator delete(pointer, std::align_val_t(HugePageSize));
+#endif
+}
+
+} // namespace memory
@@ -0,0 +1,172 @@
+#include "util/perfstats.h"
+
+#include "util/rendering.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    constexpr std::size_t NumberOfPhases = static_cast<std::size_t>(perf::Phase::Count);
+
+    std::array<std::atomic<std::uint64_t>, NumberOfPhases> _currentPhaseNanoseconds = {};
+
+    perf::SampleRing _frameTimes;
+    std::array<perf::SampleRing, NumberOfPhases> _phaseTimes;
+    perf::SampleRing _particleCounts;
+} // namespace
+
+namespace perf {
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Simulation: return "Simulation";
+        case Phase::Pack: return "Pack";
+        case Phase::Upload: return "Upload";
+        case Phase::Draw: return "Draw";
+        default: return "Unknown";
+    }
+}
+
+SampleRing::SampleRing(std::size_t capacity) : samples(capacity, 0.0f) {
+    assert(capacity > 0);
+}
+
+void SampleRing::push(float value) {
+    samples[next] = value;
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+}
+
+std::size_t SampleRing::size() const {
+    return count;
+}
+
+std::size_t SampleRing::capacity() const {
+    return samples.size();
+}
+
+const float* SampleRing::data() const {
+    return samples.data();
+}
+
+std::size_t SampleRing::offset() const {
+    return count == samples.size() ? next : 0;
+}
+
+float SampleRing::latest() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    return samples[(next + samples.size() - 1) % samples.size()];
+}
+
+float SampleRing::mean() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    return sum / count;
+}
+
+float SampleRing::percentile(float p) const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    // Samples [0, count) are the valid ones whether or not the ring has wrapped
+    sorted.assign(samples.begin(), samples.begin() + count);
+    const float rank = std::clamp(p, 0.0f, 100.0f) / 100.0f * (count - 1);
+    const std::size_t index = static_cast<std::size_t>(rank + 0.5f);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void SampleRing::histogram(float* bins, int binCount, float maxValue) const {
+    assert(binCount > 0);
+    std::fill(bins, bins + binCount, 0.0f);
+    if (maxValue <= 0.0f) {
+        return;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        const int bin = static_cast<int>(samples[i] / maxValue * binCount);
+        bins[std::clamp(bin, 0, binCount - 1)] += 1.0f;
+    }
+}
+
+void addTime(Phase phase, double seconds) {
+    assert(phase != Phase::Count);
+    const std::uint64_t nanoseconds = static_cast<std::uint64_t>(seconds * 1e9);
+    _currentPhaseNanoseconds[static_cast<std::size_t>(phase)].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+ScopedTimer::ScopedTimer(Phase inPhase) : phase(inPhase), start(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    addTime(phase, elapsed.count());
+}
+
+void endFrame(float frameTime, std::size_t liveParticles) {
+    _frameTimes.push(frameTime);
+    for (std::size_t i = 0; i < NumberOfPhases; i++) {
+        const std::uint64_t nanoseconds = _currentPhaseNanoseconds[i].exchange(0, std::memory_order_relaxed);
+        _phaseTimes[i].push(static_cast<float>(nanoseconds * 1e-9));
+    }
+    _particleCounts.push(static_cast<float>(liveParticles));
+}
+
+const SampleRing& frameTimes() {
+    return _frameTimes;
+}
+
+const SampleRing& phaseTimes(Phase phase) {
+    assert(phase != Phase::Count);
+    return _phaseTimes[static_cast<std::size_t>(phase)];
+}
+
+const SampleRing& particleCounts() {
+    return _particleCounts;
+}
+
+void showPanel() {
+    char buffer[128];
+
+    ui::beginGroup("Prestanda");
+        const float p50 = _frameTimes.percentile(50.0f);
+        const float p95 = _frameTimes.percentile(95.0f);
+        const float p99 = _frameTimes.percentile(99.0f);
+        std::snprintf(buffer, sizeof(buffer), "Frame time p50 %.2f ms  p95 %.2f ms  p99 %.2f ms",
+                      p50 * 1000.0f, p95 * 1000.0f, p99 * 1000.0f);
+        ui::text(buffer, p99 > 1.0f / 30.0f ? Color(1.0f, 0.4f, 0.3f) : Color(1, 1, 1));
+
+        ui::plotLines("Frame time", _frameTimes.data(), static_cast<int>(_frameTimes.size()),
+                      static_cast<int>(_frameTimes.offset()), 0.0f, p99 * 1.25f);
+
+        constexpr int NumberOfBins = 32;
+        float bins[NumberOfBins];
+        _frameTimes.histogram(bins, NumberOfBins, p99 * 1.25f);
+        ui::plotHistogram("Frame time histogram", bins, NumberOfBins);
+
+        for (std::size_t i = 0; i < NumberOfPhases; i++) {
+            const SampleRing& times = _phaseTimes[i];
+            std::snprintf(buffer, sizeof(buffer), "%-10s %7.3f ms  (p95 %.3f ms)",
+                          phaseName(static_cast<Phase>(i)), times.mean() * 1000.0f,
+                          times.percentile(95.0f) * 1000.0f);
+            ui::text(buffer);
+        }
+
+        // Throughput is the number of particles simulated per second of simulation time
+        const float live = _particleCounts.latest();
+        const float simulationTime = phaseTimes(Phase::Simulation).mean();
+        std::snprintf(buffer, sizeof(buffer), "Live particles %.0f  (%.2f M particles/s)", live,
+                      simulationTime > 0.0f ? live / simulationTime * 1e-6f : 0.0f);
+        ui::text(buffer);
+    ui::endGroup();
+}
+
+} // namespace perf
@@ -0,0 +1,146 @@
+#include "util/random.h"
+
+#include "util/simd.h"
+
+namespace {
+
+// The multipliers and Weyl constants from the Random123 reference implementation
+constexpr std::uint32_t Multiplier0 = 0xD2511F53;
+constexpr std::uint32_t Multiplier1 = 0xCD9E8D57;
+constexpr std::uint32_t Weyl0 = 0x9E3779B9;
+constexpr std::uint32_t Weyl1 = 0xBB67AE85;
+constexpr int Rounds = 10;
+
+#ifdef PARTICLESYSTEM_SSE
+// 32 x 32 -> 64 bit multiplication of four lanes, split into the low and high halves.
+// SSE2 only multiplies the even lanes, so the odd lanes are shifted down first
+void mulHiLo(__m128i a, __m128i multiplier, __m128i& hi, __m128i& lo) {
+    const __m128i even = _mm_mul_epu32(a, multiplier);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), multiplier);
+    lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+}
+
+__m128 toUnitFloats(__m128i bits) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(bits, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+// Elements index to index + 3, one per lane, number k of all four elements goes to out[k]
+void philoxLanes(std::uint64_t index, rng::Key key, std::uint32_t id, std::uint32_t purpose, __m128 out[4]) {
+    const __m128i multiplier0 = _mm_set1_epi32(static_cast<int>(Multiplier0));
+    const __m128i multiplier1 = _mm_set1_epi32(static_cast<int>(Multiplier1));
+    alignas(16) std::uint32_t lo[4], hi[4];
+    for (int lane = 0; lane < 4; lane++) {
+        lo[lane] = std::uint32_t(index + lane);
+        hi[lane] = std::uint32_t((index + lane) >> 32);
+    }
+    __m128i c0 = _mm_load_si128(reinterpret_cast<const __m128i*>(lo));
+    __m128i c1 = _mm_load_si128(reinterpret_cast<const __m128i*>(hi));
+    __m128i c2 = _mm_set1_epi32(static_cast<int>(id));
+    __m128i c3 = _mm_set1_epi32(static_cast<int>(purpose));
+    std::uint32_t k0 = key[0];
+    std::uint32_t k1 = key[1];
+
+    for (int round = 0; round < Rounds; round++) {
+        __m128i hi0, lo0, hi1, lo1;
+        mulHiLo(c0, multiplier0, hi0, lo0);
+        mulHiLo(c2, multiplier1, hi1, lo1);
+        c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(static_cast<int>(k0)));
+        c1 = lo1;
+        c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(static_cast<int>(k1)));
+        c3 = lo0;
+        k0 += Weyl0;
+        k1 += Weyl1;
+    }
+
+    out[0] = toUnitFloats(c0);
+    out[1] = toUnitFloats(c1);
+    out[2] = toUnitFloats(c2);
+    out[3] = toUnitFloats(c3);
+}
+#endif // PARTICLESYSTEM_SSE
+
+} // namespace
+
+namespace rng {
+
+Counter philox(Counter counter, Key key) {
+    for (int round = 0; round < Rounds; round++) {
+        const std::uint64_t product0 = std::uint64_t(Multiplier0) * counter[0];
+        const std::uint64_t product1 = std::uint64_t(Multiplier1) * counter[2];
+        counter = {
+            std::uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+            std::uint32_t(product1),
+            std::uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+            std::uint32_t(product0)
+        };
+        key[0] += Weyl0;
+        key[1] += Weyl1;
+    }
+    return counter;
+}
+
+Stream::Stream(std::uint64_t seed, std::uint32_t inId, std::uint32_t inPurpose)
+    : key{ std::uint32_t(seed), std::uint32_t(seed >> 32) }
+    , id(inId)
+    , purpose(inPurpose)
+{}
+
+std::array<float, 4> Stream::uniform4(std::uint64_t index) const {
+    const Counter bits = philox({ std::uint32_t(index), std::uint32_t(index >> 32), id, purpose }, key);
+    return { toUnitFloat(bits[0]), toUnitFloat(bits[1]), toUnitFloat(bits[2]), toUnitFloat(bits[3]) };
+}
+
+void Stream::uniformBatch(std::uint64_t firstIndex, std::size_t count, float* const out[4]) const {
+    std::size_t i = 0;
+#ifdef PARTICLESYSTEM_SSE
+    // Each lane runs its own generator
+    for (; i + 4 <= count; i += 4) {
+        __m128 values[4];
+        philoxLanes(firstIndex + i, key, id, purpose, values);
+        for (int k = 0; k < 4; k++) {
+            _mm_storeu_ps(out[k] + i, values[k]);
+        }
+    }
+#endif // PARTICLESYSTEM_SSE
+
+    for (; i < count; i++) {
+        const std::array<float, 4> values = uniform4(firstIndex + i);
+        for (int k = 0; k < 4; k++) {
+            out[k][i] = values[k];
+        }
+    }
+}
+
+void Stream::uniformSequence(std::uint64_t firstNumber, std::size_t count, float* out) const {
+    std::size_t i = 0;
+    // The rest of the element that the sequence starts in
+    if (firstNumber % 4 != 0) {
+        const std::array<float, 4> values = uniform4(firstNumber / 4);
+        for (std::size_t k = firstNumber % 4; k < 4 && i < count; k++) {
+            out[i++] = values[k];
+        }
+    }
+#ifdef PARTICLESYSTEM_SSE
+    // Four whole elements at a time, transposed so that each element is stored in order
+    for (; i + 16 <= count; i += 16) {
+        __m128 values[4];
+        philoxLanes((firstNumber + i) / 4, key, id, purpose, values);
+        _MM_TRANSPOSE4_PS(values[0], values[1], values[2], values[3]);
+        for (int k = 0; k < 4; k++) {
+            _mm_storeu_ps(out + i + 4 * k, values[k]);
+        }
+    }
+#endif // PARTICLESYSTEM_SSE
+
+    for (; i < count; i += 4) {
+        const std::array<float, 4> values = uniform4((firstNumber + i) / 4);
+        for (std::size_t k = 0; k < 4 && i + k < count; k++) {
+            out[i + k] = values[k];
+        }
+    }
+}
+
+} // namespace rng
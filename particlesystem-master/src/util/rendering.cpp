@@ -1,5 +1,6 @@
 #include "util/rendering.h"
 
+#include "util/perfstats.h"
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include "imgui.h"
@@ -10,6 +11,8 @@
 #include <assert.h>
 #include <chrono>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -24,18 +27,13 @@
 
 namespace {
 
-// Holds the pointer to the active (and only) window
-GLFWwindow* _window = nullptr;
-struct { float r = 0.05f; float g = 0.1f; float b = 0.1f; } _backgroundColor;
+// The number of renderers that are alive, GLFW is terminated when the last one goes away
+int _numberOfRenderers = 0;
 
-// Structure to hold information to render an individual type of renderable object, in
-// this case, particles, emitters, and forces
-struct Renderable {
-    ~Renderable() {
-        glDeleteVertexArrays(1, &vao);
-        vao = 0;
-        glDeleteBuffers(1, &vbo);
-        vbo = 0;
+// The program and shader objects that are used to render an individual type of object,
+// in this case, particles, emitters, and forces. They are shared by all layers
+struct Program {
+    void destroy() {
         glDeleteProgram(shaderProgram);
         shaderProgram = 0;
         glDeleteShader(vertexShader);
@@ -46,18 +44,24 @@ struct Renderable {
         fragmentShader = 0;
     }
 
-    GLuint vao = 0;
-    GLuint vbo = 0;
-
     GLuint shaderProgram = 0;
     GLuint vertexShader = 0;
     GLuint geometryShader = 0;
     GLuint fragmentShader = 0;
 };
 
-Renderable _particles;
-Renderable _emitters;
-Renderable _forces;
+// The vertex array and buffer that hold the data of one type of object in one layer
+struct Buffer {
+    void destroy() {
+        glDeleteVertexArrays(1, &vao);
+        vao = 0;
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+
+    GLuint vao = 0;
+    GLuint vbo = 0;
+};
 
 
 /**
@@ -634,38 +638,132 @@ void createForceGLObjects(GLuint& vao, GLuint& vbo) {
     assert(vbo != 0);
 }
 
-void updateWindowSize([[ maybe_unused ]] GLFWwindow* window, int width, int height) {
+/**
+ * Uploads \p data into \p buffer and draws it with \p program as points. The upload and the
+ * draw call are measured separately for the performance panel.
+ */
+template <typename T>
+void uploadAndDraw(const Buffer& buffer, const Program& program, const std::vector<T>& data) {
+    assert(buffer.vao);
+    assert(buffer.vbo);
+    assert(program.shaderProgram);
+
+    {
+        perf::ScopedTimer timer(perf::Phase::Upload);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(T), data.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    {
+        // Measures the submission on the CPU, the GPU executes the draw asynchronously
+        perf::ScopedTimer timer(perf::Phase::Draw);
+        glBindVertexArray(buffer.vao);
+        glUseProgram(program.shaderProgram);
+        glDrawArrays(GL_POINTS, 0, static_cast<int>(data.size()));
+        glUseProgram(0);
+        glBindVertexArray(0);
+    }
+}
+
+} // namespace
+
+namespace rendering {
+
+void LayerQueue::submitParticles(int layer, const std::vector<ParticleInfo>& particles) {
+    assert(layer >= 0 && layer < NumberOfLayers);
+    Slot& slot = slots[layer];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.contents.particles.insert(slot.contents.particles.end(), particles.begin(), particles.end());
+}
+
+void LayerQueue::submitEmitters(int layer, const std::vector<EmitterInfo>& emitters) {
+    assert(layer >= 0 && layer < NumberOfLayers);
+    Slot& slot = slots[layer];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.contents.emitters.insert(slot.contents.emitters.end(), emitters.begin(), emitters.end());
+}
+
+void LayerQueue::submitForces(int layer, const std::vector<ForceInfo>& forces) {
+    assert(layer >= 0 && layer < NumberOfLayers);
+    Slot& slot = slots[layer];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.contents.forces.insert(slot.contents.forces.end(), forces.begin(), forces.end());
+}
+
+void LayerQueue::drain(const std::function<void(int layer, const Layer& contents)>& function) {
+    for (int i = 0; i < NumberOfLayers; i++) {
+        Slot& slot = slots[i];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        Layer& contents = slot.contents;
+        if (contents.particles.empty() && contents.emitters.empty() && contents.forces.empty()) {
+            continue;
+        }
+        function(i, contents);
+        // Keep the memory around for the next frame
+        contents.particles.clear();
+        contents.emitters.clear();
+        contents.forces.clear();
+    }
+}
+
+struct Renderer::State {
+    // The GPU buffers that one layer is uploaded into. They are created on the first flush
+    // that has data for the layer, since the layer can be filled from threads that do not
+    // have the GL context
+    struct LayerBuffers {
+        Buffer particleBuffer;
+        Buffer emitterBuffer;
+        Buffer forceBuffer;
+    };
+
+    GLFWwindow* window = nullptr;
+    bool ownsUi = false;
+    struct { float r = 0.05f; float g = 0.1f; float b = 0.1f; } backgroundColor;
+
+    Program particleProgram;
+    Program emitterProgram;
+    Program forceProgram;
+    LayerQueue layers;
+    std::array<LayerBuffers, Renderer::NumberOfLayers> buffers;
+
+    // Stores the timestamp when the previous frame was finished
+    std::chrono::time_point<std::chrono::high_resolution_clock> prevFrameTime;
+};
+
+namespace {
+
+void updateWindowSize(GLFWwindow* window, int width, int height) {
     ZoneScoped
 
-    assert(window == _window); // Just in case something things to just add a window
+    Renderer::State* state = static_cast<Renderer::State*>(glfwGetWindowUserPointer(window));
+    assert(state && state->window == window);
 
     // Update render window
+    glfwMakeContextCurrent(window);
     glViewport(0, 0, width, height);
 
     {
-        assert(_emitters.shaderProgram);
-        glUseProgram(_emitters.shaderProgram);
-        const GLint loc = glGetUniformLocation(_emitters.shaderProgram, "windowSize");
+        assert(state->emitterProgram.shaderProgram);
+        glUseProgram(state->emitterProgram.shaderProgram);
+        const GLint loc = glGetUniformLocation(state->emitterProgram.shaderProgram, "windowSize");
         assert(loc != -1);
         glUniform2i(loc, width, height);
     }
     {
-        assert(_forces.shaderProgram);
-        glUseProgram(_forces.shaderProgram);
-        const GLint loc = glGetUniformLocation(_forces.shaderProgram, "windowSize");
+        assert(state->forceProgram.shaderProgram);
+        glUseProgram(state->forceProgram.shaderProgram);
+        const GLint loc = glGetUniformLocation(state->forceProgram.shaderProgram, "windowSize");
         assert(loc != -1);
         glUniform2i(loc, width, height);
     }
 }
 
-// Stores the timestamp when the previous frame was finished
-std::chrono::time_point<std::chrono::high_resolution_clock> prevFrameTime;
+// The renderer that is used by the free functions below
+std::unique_ptr<Renderer> _renderer;
 
 } // namespace
 
-namespace rendering {
-
-void createWindow() {
+Renderer::Renderer(const char* title) : state(std::make_unique<State>()) {
     ZoneScoped
 
     //
@@ -674,17 +772,20 @@ void createWindow() {
     constexpr const int Width = 850;
     constexpr const int Height = 850;
 
-    glfwInit();
+    if (_numberOfRenderers == 0) {
+        glfwInit();
+    }
+    _numberOfRenderers++;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    assert(_window == nullptr);
-    _window = glfwCreateWindow(Width, Height, "Particle System", nullptr, nullptr);
-    glfwMakeContextCurrent(_window);
+    state->window = glfwCreateWindow(Width, Height, title, nullptr, nullptr);
+    glfwMakeContextCurrent(state->window);
     glfwSwapInterval(0);
-    glfwSetWindowSizeCallback(_window, updateWindowSize);
+    glfwSetWindowUserPointer(state->window, state.get());
+    glfwSetWindowSizeCallback(state->window, updateWindowSize);
 
     //
     // Initialize the GLAD OpenGL wrapper
@@ -702,182 +803,160 @@ void createWindow() {
     glDisable(GL_CULL_FACE);
 
     //
-    // Initialize ImGui UI library
+    // Initialize ImGui UI library, only the first window gets a user interface
     //
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForOpenGL(_window, true);
-    ImGuiIO& io = ImGui::GetIO();
-    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
-    ImGui_ImplOpenGL3_Init();
-    ImGuiStyle& style = ImGui::GetStyle();
-    style.WindowRounding = 0.f;
-    style.WindowTitleAlign.x = 0.5f;
-    style.WindowMenuButtonPosition = 0;
+    if (ImGui::GetCurrentContext() == nullptr) {
+        state->ownsUi = true;
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGui::StyleColorsDark();
+        ImGui_ImplGlfw_InitForOpenGL(state->window, true);
+        ImGuiIO& io = ImGui::GetIO();
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+        ImGui_ImplOpenGL3_Init();
+        ImGuiStyle& style = ImGui::GetStyle();
+        style.WindowRounding = 0.f;
+        style.WindowTitleAlign.x = 0.5f;
+        style.WindowMenuButtonPosition = 0;
+    }
 
 
     //
-    // Setup OpenGL objects for particles
+    // Setup OpenGL programs for particles, emitters, and forces
     //
     createParticleShader(
-        _particles.shaderProgram,
-        _particles.vertexShader, _particles.fragmentShader
+        state->particleProgram.shaderProgram,
+        state->particleProgram.vertexShader, state->particleProgram.fragmentShader
     );
-    createParticleGLObjects(_particles.vao, _particles.vbo);
-
-
-    //
-    // Setup OpenGL objects for emitters
-    //
     createEmitterShader(
-        _emitters.shaderProgram,
-        _emitters.vertexShader, _emitters.geometryShader, _emitters.fragmentShader
+        state->emitterProgram.shaderProgram,
+        state->emitterProgram.vertexShader, state->emitterProgram.geometryShader,
+        state->emitterProgram.fragmentShader
     );
-    createEmitterGLObjects(_emitters.vao, _emitters.vbo);
-
-
-    //
-    // Setup OpenGL objects for forces
-    //
     createForceShader(
-        _forces.shaderProgram,
-        _forces.vertexShader, _forces.geometryShader, _forces.fragmentShader
+        state->forceProgram.shaderProgram,
+        state->forceProgram.vertexShader, state->forceProgram.geometryShader,
+        state->forceProgram.fragmentShader
     );
-    createForceGLObjects(_forces.vao, _forces.vbo);
 
 
     // Sets the uniforms for the window height and width to specify the size of emitters
     // and forces
-    updateWindowSize(_window, Width, Height);
-    prevFrameTime = std::chrono::high_resolution_clock::now();
+    updateWindowSize(state->window, Width, Height);
+    state->prevFrameTime = std::chrono::high_resolution_clock::now();
     checkOpenGLError("postInit");
 }
 
-void destroyWindow() {
+Renderer::~Renderer() {
     ZoneScoped
-    // Destroy the GL objects for the three different renderable types
-    _particles = {};
-    _emitters = {};
-    _forces = {};
+    glfwMakeContextCurrent(state->window);
+
+    // Destroy the GL objects of all layers and the shared programs
+    for (State::LayerBuffers& layer : state->buffers) {
+        layer.particleBuffer.destroy();
+        layer.emitterBuffer.destroy();
+        layer.forceBuffer.destroy();
+    }
+    state->particleProgram.destroy();
+    state->emitterProgram.destroy();
+    state->forceProgram.destroy();
 
     // Cleanup ImGui
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (state->ownsUi) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     // Cleanup GLFW
-    glfwDestroyWindow(_window);
-    glfwTerminate();
+    glfwDestroyWindow(state->window);
+    _numberOfRenderers--;
+    if (_numberOfRenderers == 0) {
+        glfwTerminate();
+    }
 }
 
-void setBackgroundColor(float r, float g, float b) {
+void Renderer::setBackgroundColor(float r, float g, float b) {
     assert(r >= 0.f && r <= 1.f);
     assert(g >= 0.f && g <= 1.f);
     assert(b >= 0.f && b <= 1.f);
 
-    _backgroundColor = { r, g, b };
+    state->backgroundColor = { r, g, b };
 }
 
-float beginFrame() {
+float Renderer::beginFrame() {
     ZoneScoped
+    glfwMakeContextCurrent(state->window);
     checkOpenGLError("beginFrame (begin)");
     // Compute how much time has passed since the beginning of the last frame
     auto currentTime = std::chrono::high_resolution_clock::now();
-    const std::chrono::nanoseconds ns = currentTime - prevFrameTime;
+    const std::chrono::nanoseconds ns = currentTime - state->prevFrameTime;
     const double milliseconds = ns.count() / 1e9;
     const double dt = milliseconds;
     TracyPlot("deltatime", dt);
-    prevFrameTime = currentTime;
+    state->prevFrameTime = currentTime;
 
     // Query the events from the operating system, such as input from mouse or keyboards
     glfwPollEvents();
 
     // Clear the rendering buffer with the selected background color
-    glClearColor(_backgroundColor.r, _backgroundColor.g, _backgroundColor.b, 1.f);
+    glClearColor(state->backgroundColor.r, state->backgroundColor.g, state->backgroundColor.b, 1.f);
     glClear(GL_COLOR_BUFFER_BIT);
 
     checkOpenGLError("beginFrame (end)");
     return static_cast<float>(dt);
 }
 
-void renderParticles(const std::vector<ParticleInfo>& particleData) {
-    ZoneScoped
-    checkOpenGLError("updateParticles (begin)");
-
-    assert(_particles.vao);
-    assert(_particles.vbo);
-    assert(_particles.shaderProgram);
-
-    // Upload the passed particle information to the GPU
-    glBindBuffer(GL_ARRAY_BUFFER, _particles.vbo);
-    glBufferData(GL_ARRAY_BUFFER, particleData.size() * sizeof(ParticleInfo), particleData.data(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Plot the number of particles and make them available through Tracy
-    TracyPlot("Particles", int64_t(_particles.number));
-
-    glBindVertexArray(_particles.vao);
-    glUseProgram(_particles.shaderProgram);
-    glDrawArrays(GL_POINTS, 0, static_cast<int>(particleData.size()));
-    glUseProgram(0);
-    glBindVertexArray(0);
-
-    checkOpenGLError("updateParticles (end)");
+void Renderer::submitParticles(int layer, const std::vector<ParticleInfo>& particles) {
+    state->layers.submitParticles(layer, particles);
 }
 
-void renderEmitters(const std::vector<EmitterInfo>& emitterData) {
-    ZoneScoped
-    checkOpenGLError("updateEmitters (begin)");
-
-    assert(_emitters.vao);
-    assert(_emitters.vbo);
-    assert(_emitters.shaderProgram);
-
-    // Upload the passed emitter information to the GPU
-    glBindBuffer(GL_ARRAY_BUFFER, _emitters.vbo);
-    glBufferData(GL_ARRAY_BUFFER, emitterData.size() * sizeof(EmitterInfo), emitterData.data(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Plot the number of emitters and make them available through Tracy
-    TracyPlot("Emitters", int64_t(_emitters.number));
-
-    glBindVertexArray(_emitters.vao);
-    glUseProgram(_emitters.shaderProgram);
-    glDrawArrays(GL_POINTS, 0, static_cast<int>(emitterData.size()));
-    glUseProgram(0);
-    glBindVertexArray(0);
+void Renderer::submitEmitters(int layer, const std::vector<EmitterInfo>& emitters) {
+    state->layers.submitEmitters(layer, emitters);
+}
 
-    checkOpenGLError("updateEmitters (end)");
+void Renderer::submitForces(int layer, const std::vector<ForceInfo>& forces) {
+    state->layers.submitForces(layer, forces);
 }
 
-void renderForces(const std::vector<ForceInfo>& forceData) {
+void Renderer::flush() {
     ZoneScoped
-    checkOpenGLError("renderForces (begin)");
-
-    assert(_forces.vao);
-    assert(_forces.vbo);
-    assert(_forces.shaderProgram);
+    checkOpenGLError("flush (begin)");
+    glfwMakeContextCurrent(state->window);
+
+    std::size_t numberOfParticles = 0;
+    std::size_t numberOfEmitters = 0;
+    std::size_t numberOfForces = 0;
+    state->layers.drain([&](int index, const LayerQueue::Layer& layer) {
+        State::LayerBuffers& buffers = state->buffers[index];
+        if (buffers.particleBuffer.vao == 0) {
+            createParticleGLObjects(buffers.particleBuffer.vao, buffers.particleBuffer.vbo);
+            createEmitterGLObjects(buffers.emitterBuffer.vao, buffers.emitterBuffer.vbo);
+            createForceGLObjects(buffers.forceBuffer.vao, buffers.forceBuffer.vbo);
+        }
 
-    // Upload the passed forces information to the GPU
-    glBindBuffer(GL_ARRAY_BUFFER, _forces.vbo);
-    glBufferData(GL_ARRAY_BUFFER, forceData.size() * sizeof(ForceInfo), forceData.data(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);    
+        // Each layer is drawn completely before the next one, so higher layers end up on top
+        uploadAndDraw(buffers.particleBuffer, state->particleProgram, layer.particles);
+        uploadAndDraw(buffers.emitterBuffer, state->emitterProgram, layer.emitters);
+        uploadAndDraw(buffers.forceBuffer, state->forceProgram, layer.forces);
 
-    // Plot the number of forces and make them available through Tracy
-    TracyPlot("Forces", int64_t(forceData.size()));
+        numberOfParticles += layer.particles.size();
+        numberOfEmitters += layer.emitters.size();
+        numberOfForces += layer.forces.size();
+    });
 
-    glBindVertexArray(_forces.vao);
-    glUseProgram(_forces.shaderProgram);
-    glDrawArrays(GL_POINTS, 0, static_cast<int>(forceData.size()));
-    glUseProgram(0);
-    glBindVertexArray(0);
+    // Plot the number of objects and make them available through Tracy
+    TracyPlot("Particles", int64_t(numberOfParticles));
+    TracyPlot("Particle bytes uploaded", int64_t(numberOfParticles * sizeof(ParticleInfo)));
+    TracyPlot("Emitters", int64_t(numberOfEmitters));
+    TracyPlot("Forces", int64_t(numberOfForces));
 
-    checkOpenGLError("renderForces (end)");
+    checkOpenGLError("flush (end)");
 }
 
-bool endFrame() {
+bool Renderer::endFrame() {
     ZoneScoped
+    flush();
     checkOpenGLError("endFrame (begin)");
 
     {
@@ -885,15 +964,53 @@ bool endFrame() {
         // call will block until its our turn to swap the buffers (usually every 16.6 ms
         // on a 60 Hz monitor
         ZoneScopedN("Swap buffers")
-        glfwSwapBuffers(_window);
+        glfwSwapBuffers(state->window);
     }
 
     checkOpenGLError("endFrame (end)");
-    const bool shouldClose = glfwWindowShouldClose(_window);
+    const bool shouldClose = glfwWindowShouldClose(state->window);
     FrameMark
     return !shouldClose;
 }
 
+void createWindow() {
+    assert(_renderer == nullptr);
+    _renderer = std::make_unique<Renderer>();
+}
+
+void destroyWindow() {
+    _renderer = nullptr;
+}
+
+Renderer& getRenderer() {
+    assert(_renderer);
+    return *_renderer;
+}
+
+void setBackgroundColor(float r, float g, float b) {
+    getRenderer().setBackgroundColor(r, g, b);
+}
+
+float beginFrame() {
+    return getRenderer().beginFrame();
+}
+
+void renderParticles(const std::vector<ParticleInfo>& particleData) {
+    getRenderer().submitParticles(0, particleData);
+}
+
+void renderEmitters(const std::vector<EmitterInfo>& emitterData) {
+    getRenderer().submitEmitters(0, emitterData);
+}
+
+void renderForces(const std::vector<ForceInfo>& forceData) {
+    getRenderer().submitForces(0, forceData);
+}
+
+bool endFrame() {
+    return getRenderer().endFrame();
+}
+
 } // namespace rendering
 
 namespace ui {
@@ -962,6 +1079,26 @@ bool checkbox(const char* label, bool& value) {
     return ImGui::Checkbox(label, &value);
 }
 
+void plotLines(const char* label, const float* values, int count, int offset, float minValue,
+               float maxValue)
+{
+    assert(label);
+    assert(values);
+    ZoneScoped
+    if (minValue == maxValue) {
+        minValue = FLT_MAX;
+        maxValue = FLT_MAX;
+    }
+    ImGui::PlotLines(label, values, count, offset, nullptr, minValue, maxValue, ImVec2(0, 60));
+}
+
+void plotHistogram(const char* label, const float* values, int count) {
+    assert(label);
+    assert(values);
+    ZoneScoped
+    ImGui::PlotHistogram(label, values, count, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+}
+
 void beginGroup(const char* label) {
     ZoneScoped
     assert(label);
@@ -0,0 +1,121 @@
+#include "util/taskgraph.h"
+
+#include "util/threadpool.h"
+#include "Tracy.hpp"
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+TaskGraph::TaskId TaskGraph::add(const char* name, std::function<void()> function,
+                                 std::initializer_list<TaskId> dependencies)
+{
+    const TaskId id = static_cast<TaskId>(tasks.size());
+    tasks.push_back({ name, std::move(function), {}, 0, AnyThread });
+    for (TaskId dependency : dependencies) {
+        addDependency(dependency, id);
+    }
+    return id;
+}
+
+void TaskGraph::addDependency(TaskId before, TaskId after) {
+    // Dependencies only point forward, which guarantees that the graph has no cycles
+    assert(before < after);
+    assert(after < tasks.size());
+    tasks[before].successors.push_back(after);
+    tasks[after].numberOfDependencies++;
+}
+
+void TaskGraph::setPreferredThread(TaskId task, unsigned threadIndex) {
+    assert(task < tasks.size());
+    tasks[task].preferredThread = threadIndex;
+}
+
+void TaskGraph::execute(ThreadPool& pool) {
+    ZoneScoped
+    if (tasks.empty()) {
+        return;
+    }
+
+    // One ready list per thread for the tasks that prefer it, and a last one for the rest.
+    // The counters and the ready lists are only touched while holding the mutex
+    const unsigned numberOfThreads = pool.getNumberOfThreads();
+    const auto listOf = [&](TaskId id) {
+        const unsigned preferred = tasks[id].preferredThread;
+        return preferred == AnyThread ? numberOfThreads : preferred % numberOfThreads;
+    };
+    std::vector<std::uint32_t> remaining(tasks.size());
+    std::vector<std::vector<TaskId>> ready(numberOfThreads + 1);
+    std::size_t numberOfReady = 0;
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        remaining[i] = tasks[i].numberOfDependencies;
+        if (tasks[i].numberOfDependencies == 0) {
+            ready[listOf(static_cast<TaskId>(i))].push_back(static_cast<TaskId>(i));
+            numberOfReady++;
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::size_t numberOfFinished = 0;
+
+    pool.run([&](unsigned threadIndex) {
+        while (true) {
+            TaskId id;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [&]() { return numberOfReady > 0 || numberOfFinished == tasks.size(); });
+                if (numberOfReady == 0) {
+                    return;
+                }
+                // Own tasks, then shared ones, then the most recent task of another thread
+                std::vector<TaskId>* list = &ready[threadIndex];
+                if (list->empty()) {
+                    list = &ready[numberOfThreads];
+                }
+                for (unsigned other = 0; list->empty(); other++) {
+                    list = &ready[other];
+                }
+                id = list->back();
+                list->pop_back();
+                numberOfReady--;
+            }
+
+            const Task& task = tasks[id];
+            {
+                ZoneScoped
+                ZoneName(task.name, std::strlen(task.name))
+                task.function();
+            }
+
+            std::size_t numberOfNewlyReady = 0;
+            bool readyForOthers = false;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (TaskId successor : task.successors) {
+                if (--remaining[successor] == 0) {
+                    const unsigned list = listOf(successor);
+                    ready[list].push_back(successor);
+                    numberOfNewlyReady++;
+                    numberOfReady++;
+                    readyForOthers |= list != threadIndex && list != numberOfThreads;
+                }
+            }
+            numberOfFinished++;
+            if (numberOfFinished == tasks.size()) {
+                wakeUp.notify_all();
+            }
+            else if (numberOfNewlyReady > 1 || readyForOthers) {
+                // This thread takes one of them itself unless they prefer another thread
+                wakeUp.notify_all();
+            }
+        }
+    });
+}
+
+void TaskGraph::clear() {
+    tasks.clear();
+}
+
+std::size_t TaskGraph::size() const {
+    return tasks.size();
+}
@@ -0,0 +1,141 @@
+#include "util/threadpool.h"
+
+#include "Tracy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned numberOfThreads) {
+    if (numberOfThreads == 0) {
+        numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 1; i < numberOfThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+unsigned ThreadPool::getNumberOfThreads() const {
+    return static_cast<unsigned>(workers.size()) + 1;
+}
+
+void ThreadPool::workerLoop(unsigned threadIndex) {
+    std::uint64_t seenGeneration = 0;
+    while (true) {
+        const std::function<void(unsigned)>* currentJob = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+            currentJob = job;
+        }
+
+        (*currentJob)(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+        }
+        finished.notify_one();
+    }
+}
+
+void ThreadPool::run(const std::function<void(unsigned threadIndex)>& function) {
+    // Only one job at a time; a nested or concurrent call runs serially on the caller
+    std::unique_lock<std::mutex> submitLock(submitMutex, std::try_to_lock);
+    if (!submitLock.owns_lock() || workers.empty()) {
+        for (unsigned i = 0; i < getNumberOfThreads(); i++) {
+            function(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &function;
+        pending = static_cast<unsigned>(workers.size());
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    function(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return pending == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::parallelFor(std::size_t count,
+                             const std::function<void(std::size_t, std::size_t)>& function,
+                             std::size_t grainSize)
+{
+    assert(grainSize > 0);
+    if (count == 0) {
+        return;
+    }
+    if (count <= grainSize || workers.empty()) {
+        function(0, count);
+        return;
+    }
+
+    std::atomic<std::size_t> nextChunk = 0;
+    const std::size_t numberOfChunks = (count + grainSize - 1) / grainSize;
+    run([&](unsigned) {
+        ZoneScopedN("parallelFor chunk")
+        for (std::size_t c = nextChunk++; c < numberOfChunks; c = nextChunk++) {
+            const std::size_t first = c * grainSize;
+            function(first, std::min(first + grainSize, count));
+        }
+    });
+}
+
+void ThreadPool::parallelForStatic(std::size_t count,
+                                   const std::function<void(std::size_t, std::size_t)>& function)
+{
+    if (count == 0) {
+        return;
+    }
+    const unsigned numberOfThreads = getNumberOfThreads();
+    run([&](unsigned threadIndex) {
+        ZoneScopedN("parallelForStatic block")
+        std::size_t first, last;
+        staticBlock(count, numberOfThreads, threadIndex, first, last);
+        if (first < last) {
+            function(first, last);
+        }
+    });
+}
+
+void ThreadPool::staticBlock(std::size_t count, unsigned numberOfThreads, unsigned threadIndex,
+                             std::size_t& first, std::size_t& last)
+{
+    assert(threadIndex < numberOfThreads);
+    // The first count % n threads get one extra element
+    const std::size_t base = count / numberOfThreads;
+    const std::size_t extra = count % numberOfThreads;
+    first = threadIndex * base + std::min<std::size_t>(threadIndex, extra);
+    last = first + base + (threadIndex < extra ? 1 : 0);
+}
+
+unsigned ThreadPool::chunkOwner(std::size_t chunk, unsigned numberOfThreads) {
+    assert(numberOfThreads > 0);
+    return static_cast<unsigned>(chunk % numberOfThreads);
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -6,28 +6,62 @@
 //
 
 #include "wind.hpp"
+#include "util/vec2xN.h"
 
+namespace {
+    constexpr float Spread = 0.7f;          //Halva öppningsvinkeln för vindkonen
+    constexpr float MinDistanceSquared = 1e-12f;
+} // namespace
 
-Wind::Wind(vec2 inPosition, float inSize, Color inColor, float inAngle): Force(inPosition, inSize, inColor){
+Wind::Wind(vec2 inPosition, float inSize, Color inColor, float inAngle, float inRadius): Force(inPosition, inSize, inColor, inRadius){
     angle = inAngle;
     windPower = 0.01f; //Maximal vindstyrka, i Newton
+
+    //Trigonometrin görs en gång här istället för för varje partikel
+    direction = {std::cos(angle), std::sin(angle)};
+    cosSpreadSquared = std::cos(Spread)*std::cos(Spread);
 };
 
 vec2 Wind::computeForce(vec2 particlePosition){
-    float windMagnitude = 0.0f;
-    
-    //Kolla om partikeln är inom vinkel
+    //Kolla om partikeln är inom konen: dot(dist, direction) >= cos(Spread)*|dist|.
+    //Båda sidor kvadreras så att ingen sqrt behövs
     vec2 dist = particlePosition-position;
-    float particleAngle = atan(dist.x/dist.y);
-    if(abs(particleAngle-angle) <= 0.7f){
-        //Beräkna vindstyrka med hjälp av avståndet till partikeln
-        windMagnitude = -1*windPower/(sqrtf(dist.x*dist.x + dist.y*dist.y));
-    };
-    
-    //Gör om till x- och y-komponenter med hjälp av vinkeln (till partikeln) och vindstyrkan
-    vec2 force = {windMagnitude*cos(particleAngle), windMagnitude*sin(particleAngle)};
-    
-    return force;
+    float distSquared = dist.x*dist.x + dist.y*dist.y;
+    float along = dist.x*direction.x + dist.y*direction.y;
+    bool inside = along > 0.0f && along*along >= cosSpreadSquared*distSquared && distSquared > MinDistanceSquared;
+
+    //Vindstyrkan avtar som 1/|dist| i riktningen bort från källan: windPower*dist/|dist|^2
+    float scale = inside ? windPower*falloff(distSquared)/distSquared : 0.0f;
+    return dist*scale;
+}
+
+void Wind::accumulateForces(const vec2* positions, vec2* forces, std::size_t count){
+    std::size_t i = 0;
+    using simd::floatv;
+    using simd::vec2v;
+    constexpr std::size_t Width = simd::NativeWidth;
+    const vec2v source = vec2v(position);
+    const vec2v windDirection = vec2v(direction);
+    const floatv zero = 0.0f;
+    const floatv minDist = MinDistanceSquared;
+
+    for(; i + Width <= count; i += Width){
+        const vec2v dist = vec2v::load(positions + i) - source;
+        const floatv distSquared = dist.lengthSquared();
+        const floatv along = simd::dot(dist, windDirection);
+
+        //Samma kontroll som i computeForce men som en mask istället för en if-sats
+        const auto inside = (along > zero) & (along*along >= cosSpreadSquared*distSquared) & (distSquared > minDist);
+
+        floatv weight = simd::max(1.0f - distSquared*inverseRadiusSquared, zero);
+        weight = weight*weight;
+        const floatv scale = simd::select(inside, windPower*weight/simd::max(distSquared, minDist), zero);
+        (dist*scale).addTo(forces + i);
+    }
+
+    for(; i < count; i++){
+        forces[i] += computeForce(positions[i]);
+    }
 }
 
 /*void Wind::changeAngle(float newAngle) {
@@ -0,0 +1,318 @@
+#include "catch2.h"
+#include "forceField.hpp"
+#include "forceGrid.hpp"
+#include "barnesHut.hpp"
+#include "particleMesh.hpp"
+#include "gravityWell.hpp"
+#include "wind.hpp"
+
+TEST_CASE("Baked field matches the forces at the grid nodes", "[forcefield]") {
+    GravityWell well({0.1f, 0.2f}, 6.0f, {1, 1, 1});
+    std::vector<Force*> forces = { &well };
+
+    // 5 nodes between -1 and 1 puts nodes at multiples of 0.5
+    ForceField field(5);
+    REQUIRE(field.isDirty());
+    field.bake(forces);
+    REQUIRE_FALSE(field.isDirty());
+
+    const vec2 node(0.5f, -0.5f);
+    const vec2 expected = well.computeForce(node);
+    const vec2 sampled = field.sample(node);
+    REQUIRE(sampled.x == Approx(expected.x));
+    REQUIRE(sampled.y == Approx(expected.y));
+}
+
+TEST_CASE("Batch sampling matches scalar sampling", "[forcefield]") {
+    GravityWell well({0.1f, 0.2f}, 6.0f, {1, 1, 1});
+    Wind wind({-0.3f, 0.4f}, 6.0f, {1, 1, 1}, 0.7f);
+    std::vector<Force*> forces = { &well, &wind };
+
+    ForceField field(33);
+    field.bake(forces);
+
+    // Include positions outside of the domain to exercise the clamping
+    std::vector<vec2> positions;
+    for (int i = 0; i < 23; i++) {
+        positions.push_back({ -1.3f + i * 0.12f, 1.2f - i * 0.1f });
+    }
+    std::vector<vec2> result(positions.size(), vec2(1.f, 1.f));
+    field.accumulate(positions.data(), result.data(), positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        const vec2 expected = field.sample(positions[i]) + 1.f;
+        REQUIRE(result[i].x == Approx(expected.x));
+        REQUIRE(result[i].y == Approx(expected.y));
+    }
+}
+
+TEST_CASE("Wind only acts inside its cone", "[wind]") {
+    // Blowing along the positive x axis
+    Wind wind({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.f);
+
+    const vec2 inside = wind.computeForce({0.5f, 0.1f});
+    REQUIRE(inside.x > 0.f);
+    REQUIRE(inside.y > 0.f);
+    REQUIRE(inside.length() == Approx(0.01f / vec2(0.5f, 0.1f).length()));
+
+    const vec2 behind = wind.computeForce({-0.5f, 0.f});
+    REQUIRE(behind.x == 0.f);
+    REQUIRE(behind.y == 0.f);
+
+    const vec2 outside = wind.computeForce({0.1f, 0.5f});
+    REQUIRE(outside.x == 0.f);
+    REQUIRE(outside.y == 0.f);
+
+    // The source itself and a particle straight ahead (dy = 0) must stay finite
+    const vec2 atSource = wind.computeForce({0.f, 0.f});
+    REQUIRE(atSource.x == 0.f);
+    REQUIRE(atSource.y == 0.f);
+    const vec2 ahead = wind.computeForce({0.25f, 0.f});
+    REQUIRE(ahead.x == Approx(0.04f));
+    REQUIRE(ahead.y == 0.f);
+}
+
+TEST_CASE("Wind batch kernel matches computeForce", "[wind]") {
+    Wind wind({0.1f, -0.2f}, 6.0f, {1, 1, 1}, 2.3f);
+
+    std::vector<vec2> positions;
+    for (int i = 0; i < 37; i++) {
+        positions.push_back({ std::cos(i * 0.7f) * 0.9f, std::sin(i * 1.3f) * 0.8f });
+    }
+    positions.push_back({0.1f, -0.2f});
+    std::vector<vec2> result(positions.size());
+    wind.accumulateForces(positions.data(), result.data(), positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        const vec2 expected = wind.computeForce(positions[i]);
+        REQUIRE(result[i].x == Approx(expected.x));
+        REQUIRE(result[i].y == Approx(expected.y));
+    }
+}
+
+TEST_CASE("Gravity kernel matches computeForce", "[gravity]") {
+    GravityWell a({0.1f, 0.2f}, 6.0f, {1, 1, 1}, 0.05f);
+    GravityWell b({-0.6f, 0.3f}, 6.0f, {1, 1, 1}, 0.0f);
+    std::vector<GravityWell*> wells = { &a, &b };
+
+    std::vector<vec2> positions;
+    for (int i = 0; i < 29; i++) {
+        positions.push_back({ std::cos(i * 0.9f) * 0.9f, std::sin(i * 0.4f) * 0.7f });
+    }
+    // Exactly on a softened well and exactly on an unsoftened well
+    positions.push_back({0.1f, 0.2f});
+    positions.push_back({-0.6f, 0.3f});
+
+    GravityKernel kernel;
+    kernel.setWells(wells);
+    for (bool precise : { false, true }) {
+        kernel.setPrecise(precise);
+        std::vector<vec2> result(positions.size());
+        kernel.accumulate(positions.data(), result.data(), positions.size());
+
+        for (size_t i = 0; i < positions.size(); i++) {
+            const vec2 expected = a.computeForce(positions[i]) + b.computeForce(positions[i]);
+            REQUIRE(std::isfinite(result[i].x));
+            REQUIRE(std::isfinite(result[i].y));
+            REQUIRE(result[i].x == Approx(expected.x).epsilon(1e-4));
+            REQUIRE(result[i].y == Approx(expected.y).epsilon(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Gravity without softening follows the inverse square law", "[gravity]") {
+    GravityWell well({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.0f);
+    const vec2 f = well.computeForce({0.5f, 0.f});
+    REQUIRE(f.x == Approx(-4.f));
+    REQUIRE(f.y == 0.f);
+}
+
+TEST_CASE("Forces with a radius fade out smoothly and cut off", "[radius]") {
+    GravityWell well({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.0f, 0.5f);
+    REQUIRE(well.getInfluenceRadius() == 0.5f);
+    REQUIRE_FALSE(well.isGlobal());
+
+    GravityWell global({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.0f);
+    REQUIRE(global.isGlobal());
+
+    // (1 - d^2/r^2)^2 at d = 0.25, r = 0.5 is 0.5625
+    REQUIRE(well.computeForce({0.25f, 0.f}).x == Approx(global.computeForce({0.25f, 0.f}).x * 0.5625f));
+    REQUIRE(well.computeForce({0.5f, 0.f}).x == 0.f);
+    REQUIRE(well.computeForce({0.9f, 0.f}).x == 0.f);
+
+    Wind wind({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.f, 0.5f);
+    REQUIRE(wind.computeForce({0.6f, 0.f}).x == 0.f);
+    REQUIRE(wind.computeForce({0.25f, 0.f}).x == Approx(0.04f * 0.5625f));
+}
+
+TEST_CASE("Culled evaluation matches evaluating every force", "[radius]") {
+    std::vector<GravityWell> wellStorage;
+    std::vector<Wind> windStorage;
+    for (int i = 0; i < 12; i++) {
+        const vec2 p(std::cos(i * 2.1f) * 0.8f, std::sin(i * 1.7f) * 0.8f);
+        wellStorage.emplace_back(p, 6.0f, Color{1, 1, 1}, 0.02f, i == 0 ? 0.f : 0.1f + i * 0.03f);
+        windStorage.emplace_back(p * -1.f, 6.0f, Color{1, 1, 1}, i * 0.5f, i == 1 ? 0.f : 0.3f);
+    }
+    std::vector<GravityWell*> wells;
+    std::vector<Wind*> winds;
+    for (GravityWell& w : wellStorage) { wells.push_back(&w); }
+    for (Wind& w : windStorage) { winds.push_back(&w); }
+
+    std::vector<vec2> positions;
+    for (int i = 0; i < 200; i++) {
+        positions.push_back({ std::cos(i * 0.37f) * 1.1f, std::sin(i * 0.61f) * 1.1f });
+    }
+
+    ForceGrid grid(8);
+    grid.build(wells, winds, true);
+    std::vector<vec2> culled(positions.size());
+    grid.accumulate(positions.data(), culled.data(), positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        vec2 expected;
+        for (GravityWell* w : wells) { expected += w->computeForce(positions[i]); }
+        for (Wind* w : winds) { expected += w->computeForce(positions[i]); }
+        REQUIRE(culled[i].x == Approx(expected.x).margin(1e-5));
+        REQUIRE(culled[i].y == Approx(expected.y).margin(1e-5));
+    }
+}
+
+TEST_CASE("Barnes-Hut with opening angle 0 is exact", "[nbody]") {
+    std::vector<vec2> positions;
+    std::vector<float> masses;
+    for (int i = 0; i < 150; i++) {
+        positions.push_back({ std::cos(i * 0.37f) * 0.9f, std::sin(i * 0.61f) * 0.7f });
+        masses.push_back(0.05f + (i % 3) * 0.05f);
+    }
+
+    auto direct = [&](size_t i) {
+        vec2 sum;
+        for (size_t j = 0; j < positions.size(); j++) {
+            if (i == j) { continue; }
+            const vec2 d = positions[j] - positions[i];
+            const float r2 = d.x * d.x + d.y * d.y + 0.01f * 0.01f;
+            sum += d * (masses[j] / (r2 * std::sqrt(r2)));
+        }
+        return sum * (2.f * masses[i]);
+    };
+
+    ThreadPool pool(3);
+    BarnesHutTree tree;
+    tree.setGravitationalConstant(2.f);
+    tree.setSoftening(0.01f);
+    tree.setOpeningAngle(0.f);
+    tree.build(positions.data(), masses.data(), positions.size());
+    REQUIRE(tree.getNumberOfNodes() > 1);
+
+    std::vector<vec2> exact(positions.size());
+    tree.accumulate(exact.data(), pool);
+    for (size_t i = 0; i < positions.size(); i++) {
+        const vec2 expected = direct(i);
+        REQUIRE(exact[i].x == Approx(expected.x).epsilon(1e-3));
+        REQUIRE(exact[i].y == Approx(expected.y).epsilon(1e-3));
+    }
+
+    // A typical opening angle stays close to the exact result
+    tree.setOpeningAngle(0.5f);
+    std::vector<vec2> approximate(positions.size());
+    tree.accumulate(approximate.data(), pool);
+    float error = 0.f;
+    float total = 0.f;
+    for (size_t i = 0; i < positions.size(); i++) {
+        error += (approximate[i] - exact[i]).length();
+        total += exact[i].length();
+    }
+    REQUIRE(error / total < 0.05f);
+}
+
+TEST_CASE("Particle-mesh gravity attracts towards a deposited mass", "[particlemesh]") {
+    ParticleMesh mesh(64);
+    mesh.setGravitationalConstant(1.f);
+    const vec2 source(0.f, 0.f);
+    const float sourceMass = 1.f;
+    mesh.depositMasses(&source, &sourceMass, 1);
+    REQUIRE(mesh.needsUpdate());
+    mesh.update();
+
+    std::vector<vec2> positions = { {0.25f, 0.f}, {0.5f, 0.f}, {-0.5f, 0.f}, {0.f, 0.5f} };
+    std::vector<float> masses(positions.size(), 1.f);
+    std::vector<vec2> forces(positions.size());
+    ThreadPool pool(2);
+    mesh.accumulate(positions.data(), masses.data(), forces.data(), positions.size(), pool);
+
+    REQUIRE(forces[1].x < 0.f);
+    REQUIRE(forces[2].x > 0.f);
+    REQUIRE(forces[3].y < 0.f);
+    REQUIRE(forces[1].x == Approx(-forces[2].x).epsilon(1e-2));
+    REQUIRE(forces[1].x == Approx(forces[3].y).epsilon(1e-2));
+    REQUIRE(std::abs(forces[0].x) > std::abs(forces[1].x));
+
+    // Away from the border the 2D field is close to G*M/r
+    REQUIRE(forces[0].x == Approx(-1.f / 0.25f).epsilon(0.15));
+}
+
+TEST_CASE("Particle-mesh wells match direct gravity near the well", "[particlemesh]") {
+    GravityWell well({0.f, 0.f}, 6.0f, {1, 1, 1}, 0.0f);
+    const vec2 wellPosition = well.getPosition();
+    const float strength = well.getStrength();
+    ParticleMesh mesh(128);
+    mesh.setWells(&wellPosition, &strength, 1);
+    mesh.update();
+
+    // Particles of different mass at the matching distance feel the same force
+    const float d = ParticleMesh::WellMatchingDistance;
+    std::vector<vec2> positions = { {d, 0.f}, {0.f, -d} };
+    std::vector<float> masses = { 0.1f, 1.f };
+    std::vector<vec2> forces(positions.size());
+    ThreadPool pool(1);
+    mesh.accumulate(positions.data(), masses.data(), forces.data(), positions.size(), pool);
+
+    const vec2 direct = well.computeForce(positions[0]);
+    REQUIRE(forces[0].x == Approx(direct.x).epsilon(0.15));
+    REQUIRE(forces[1].y == Approx(-direct.x).epsilon(0.15));
+}
+
+TEST_CASE("Particle-mesh respects the update interval", "[particlemesh]") {
+    ParticleMesh mesh(16);
+    mesh.setUpdateInterval(3);
+    REQUIRE(mesh.needsUpdate());
+    mesh.update();
+    REQUIRE_FALSE(mesh.needsUpdate());
+    mesh.update();
+    REQUIRE_FALSE(mesh.needsUpdate());
+    mesh.update();
+    REQUIRE(mesh.needsUpdate());
+}
+
+TEST_CASE("Barnes-Hut never approximates a node containing the particle", "[nbody]") {
+    // A tight cluster and one particle far away, inside the same root node
+    std::vector<vec2> positions;
+    std::vector<float> masses;
+    for (int i = 0; i < 9; i++) {
+        positions.push_back({ (i % 3) * 0.005f, (i / 3) * 0.005f });
+        masses.push_back(0.1f);
+    }
+    positions.push_back({ 1.f, 0.f });
+    masses.push_back(0.1f);
+
+    ThreadPool pool(1);
+    BarnesHutTree tree;
+    tree.setGravitationalConstant(1.f);
+    tree.setSoftening(0.f);
+    // Wide enough that the root would be approximated from the lone particle
+    tree.setOpeningAngle(1.5f);
+    tree.build(positions.data(), masses.data(), positions.size());
+
+    std::vector<vec2> forces(positions.size());
+    tree.accumulate(forces.data(), pool);
+
+    vec2 expected;
+    for (size_t j = 0; j < 9; j++) {
+        const vec2 d = positions[j] - positions[9];
+        const float r2 = d.x * d.x + d.y * d.y;
+        expected += d * (masses[j] / (r2 * std::sqrt(r2)));
+    }
+    expected = expected * masses[9];
+    REQUIRE(forces[9].x == Approx(expected.x).epsilon(1e-2));
+    REQUIRE(forces[9].y == Approx(expected.y).epsilon(1e-2));
+}
@@ -0,0 +1,43 @@
+#include "catch2.h"
+#include "framePipeline.hpp"
+#include <vector>
+
+TEST_CASE("Pipelined frames are drawn depth frames late", "[pipeline]") {
+    for (int depth = 0; depth <= FramePipeline::MaxDepth; depth++) {
+        ParticleSystem system;
+        std::vector<std::size_t> drawnCounts;
+        FramePipeline pipeline(system, depth, [&](const RenderData& data) {
+            drawnCounts.push_back(data.particles.size());
+        });
+
+        // One particle is spawned per step, so the count identifies the step that was drawn
+        pipeline.execute([](ParticleSystem& s) { s.addUniform({0.0f, 0.0f}); });
+        for (int frame = 0; frame < 6; frame++) {
+            pipeline.runFrame({0.01f, 4.0f, 0.0f});
+        }
+
+        REQUIRE(drawnCounts.size() == static_cast<std::size_t>(6 - depth));
+        for (std::size_t i = 0; i < drawnCounts.size(); i++) {
+            REQUIRE(drawnCounts[i] == i + 1);
+        }
+        REQUIRE(pipeline.getDrawnParticleCount() == drawnCounts.back());
+    }
+}
+
+TEST_CASE("Changing the depth keeps the simulation state", "[pipeline]") {
+    ParticleSystem system;
+    std::size_t lastDrawn = 0;
+    FramePipeline pipeline(system, 2, [&](const RenderData& data) {
+        lastDrawn = data.particles.size();
+    });
+    pipeline.execute([](ParticleSystem& s) { s.addUniform({0.0f, 0.0f}); });
+    for (int frame = 0; frame < 4; frame++) {
+        pipeline.runFrame({0.01f, 4.0f, 0.0f});
+    }
+
+    // All four steps are simulated before the depth changes, the last two are never drawn
+    pipeline.setDepth(0);
+    REQUIRE(system.getParticles().size() == 4);
+    pipeline.runFrame({0.01f, 4.0f, 0.0f});
+    REQUIRE(lastDrawn == 5);
+}
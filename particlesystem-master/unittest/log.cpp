@@ -0,0 +1,106 @@
+#include "catch2.h"
+#include "util/log.h"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    template <typename... Args>
+    std::string formatted(const char* message, const Args&... args) {
+        const logging::Argument arguments[] = { logging::detail::makeArgument(args)... };
+        return logging::detail::format(message, arguments, sizeof...(Args));
+    }
+} // namespace
+
+TEST_CASE("Stored arguments are formatted like printf", "[log]") {
+    REQUIRE(formatted("%d particles", 42) == "42 particles");
+    REQUIRE(formatted("%5.2f|%-4u|%x", 3.14159, 7u, 255) == " 3.14|7   |ff");
+    REQUIRE(formatted("%zu and %ld", std::size_t(3), -4L) == "3 and -4");
+    REQUIRE(formatted("%s: %.1f%%", "speed", 50.0f) == "speed: 50.0%");
+    REQUIRE(formatted("%d", 2.9) == "2");
+    REQUIRE(formatted("%f", 2) == "2.000000");
+}
+
+TEST_CASE("Missing arguments and long strings are handled", "[log]") {
+    REQUIRE(formatted("%d and %d", 1) == "1 and %d");
+    const std::string path = "scenarios/a path that is much longer than the inline storage.txt";
+    REQUIRE(path.size() > logging::Argument::MaxStringLength);
+    REQUIRE(formatted("%s", path.c_str()) == path);
+    REQUIRE(formatted("[%70s]", path.c_str()) == "[      " + path + "]");
+    REQUIRE(formatted("%.9s|%d", path.c_str(), 3) == "scenarios|3");
+}
+
+TEST_CASE("Long strings reach the sink in full", "[log]") {
+    logging::flush();
+    std::vector<std::string> messages;
+    logging::setSink([&](logging::Level, const std::string& message) { messages.push_back(message); });
+
+    // The string is gone before the message is drained
+    {
+        std::string reason = "Could not open scenario scenarios/does-not-exist.txt";
+        LOG_ERROR("%s (%d)", reason.c_str(), 2);
+        reason.assign(reason.size(), 'x');
+    }
+    LOG_ERROR("Started scenario %s", "1M particles / 64 wells / 256 emitters");
+    logging::flush();
+    logging::setSink({});
+
+    REQUIRE(messages.size() == 2);
+    REQUIRE(messages[0] == "Could not open scenario scenarios/does-not-exist.txt (2)");
+    REQUIRE(messages[1] == "Started scenario 1M particles / 64 wells / 256 emitters");
+}
+
+TEST_CASE("Levels filter messages at runtime", "[log]") {
+    const logging::Level original = logging::getLevel();
+    logging::setLevel(logging::Level::Warning);
+    REQUIRE_FALSE(logging::isEnabled(logging::Level::Info));
+    REQUIRE(logging::isEnabled(logging::Level::Error));
+
+    // Disabled messages do not evaluate their arguments
+    int evaluated = 0;
+    LOG_INFO("%d", ++evaluated);
+    REQUIRE(evaluated == 0);
+
+    logging::setLevel(original);
+}
+
+TEST_CASE("Messages from several threads are drained without loss", "[log]") {
+    const logging::Level original = logging::getLevel();
+    logging::setLevel(logging::Level::Debug);
+    logging::flush();
+    const std::uint64_t droppedBefore = logging::getNumberOfDroppedMessages();
+    // Captured instead of written to stderr
+    std::vector<std::string> messages;
+    logging::setSink([&](logging::Level level, const std::string& message) {
+        if (level == logging::Level::Debug) {
+            messages.push_back(message);
+        }
+    });
+
+    std::thread other([]() {
+        for (int i = 0; i < 20; i++) {
+            LOG_DEBUG("log test from worker thread %d", i);
+        }
+    });
+    for (int i = 0; i < 20; i++) {
+        LOG_DEBUG("log test from main thread %d", i);
+    }
+    other.join();
+    logging::flush();
+    logging::setSink(nullptr);
+    logging::setLevel(original);
+
+    REQUIRE(logging::getNumberOfDroppedMessages() == droppedBefore);
+    REQUIRE(messages.size() == 40);
+    // Each thread's messages stay in order
+    const auto position = [&](const std::string& message) {
+        return std::find(messages.begin(), messages.end(), message) - messages.begin();
+    };
+    for (int i = 0; i + 1 < 20; i++) {
+        REQUIRE(position("log test from main thread " + std::to_string(i)) <
+                position("log test from main thread " + std::to_string(i + 1)));
+        REQUIRE(position("log test from worker thread " + std::to_string(i)) <
+                position("log test from worker thread " + std::to_string(i + 1)));
+    }
+}
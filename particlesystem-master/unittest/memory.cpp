@@ -0,0 +1,83 @@
+#include "catch2.h"
+#include "util/memory.h"
+#include "util/threadpool.h"
+#include <algorithm>
+#include <numeric>
+
+TEST_CASE("Static blocks cover the range without overlap", "[threadpool]") {
+    for (std::size_t count : { 0, 1, 7, 100, 1001 }) {
+        std::size_t expectedFirst = 0;
+        for (unsigned t = 0; t < 4; t++) {
+            std::size_t first, last;
+            ThreadPool::staticBlock(count, 4, t, first, last);
+            REQUIRE(first == expectedFirst);
+            REQUIRE(last >= first);
+            REQUIRE(last - first <= count / 4 + 1);
+            expectedFirst = last;
+        }
+        REQUIRE(expectedFirst == count);
+    }
+}
+
+TEST_CASE("parallelForStatic visits every element once", "[threadpool]") {
+    ThreadPool pool(3);
+    std::vector<int> visits(10000, 0);
+    pool.parallelForStatic(visits.size(), [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            visits[i]++;
+        }
+    });
+    REQUIRE(std::accumulate(visits.begin(), visits.end(), 0) == 10000);
+    REQUIRE(*std::min_element(visits.begin(), visits.end()) == 1);
+}
+
+TEST_CASE("Large vectors keep their contents with every policy", "[memory]") {
+    const memory::Policy original = memory::getPolicy();
+
+    for (bool hugePages : { false, true }) {
+        for (bool firstTouch : { false, true }) {
+            memory::Policy policy;
+            policy.hugePages = hugePages;
+            policy.numaFirstTouch = firstTouch;
+            memory::setPolicy(policy);
+
+            // Grows from small heap allocations into mapped ones
+            memory::LargeVector<float> values;
+            for (int i = 0; i < 1 << 20; i++) {
+                values.push_back(static_cast<float>(i));
+            }
+            REQUIRE(values.size() * sizeof(float) >= memory::largeAllocationThreshold);
+            REQUIRE(values.front() == 0.0f);
+            REQUIRE(values[12345] == 12345.0f);
+            REQUIRE(values.back() == static_cast<float>((1 << 20) - 1));
+        }
+    }
+
+    memory::setPolicy(original);
+}
+
+TEST_CASE("Chunk owners change only on page boundaries", "[memory]") {
+    // Otherwise a page holds the elements of two owners and is placed by one of them
+    const std::size_t page = memory::pageSize();
+    REQUIRE(page > 0);
+    for (std::size_t elementSize : { 4, 8, 12, 24, 64 }) {
+        for (std::size_t chunk = 1; chunk < 16; chunk++) {
+            REQUIRE(ThreadPool::chunkOwner(chunk, 4) != ThreadPool::chunkOwner(chunk - 1, 4));
+            REQUIRE(chunk * memory::chunkSize * elementSize % page == 0);
+        }
+    }
+}
+
+TEST_CASE("Chunk owners do not depend on the array size", "[threadpool]") {
+    // Growing an array must not move the chunks it already had to other threads
+    for (unsigned threads : { 1u, 3u, 8u }) {
+        unsigned used = 0;
+        for (std::size_t chunk = 0; chunk < 64; chunk++) {
+            const unsigned owner = ThreadPool::chunkOwner(chunk, threads);
+            REQUIRE(owner < threads);
+            REQUIRE(owner == ThreadPool::chunkOwner(chunk + threads, threads));
+            used |= 1u << owner;
+        }
+        REQUIRE(used == (1u << threads) - 1);
+    }
+}
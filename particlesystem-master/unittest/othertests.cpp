@@ -14,9 +14,134 @@ TEST_CASE("If the particles are deleted correctly", "ParticleSystem") {
 		vec2 inPosition = { 0.5f, -0.5f };
 		testSystem.addUniform(inPosition);
 		testSystem.update(dt, numberOfSpawnDirections, angle);
-		REQUIRE(testSystem.getParticles[0].getLifeTime() == 60.0f);
+		// The particle is spawned and then lives through the whole 60 second step
+		REQUIRE(testSystem.getParticles().size() == 1);
+		REQUIRE(testSystem.getParticles()[0].getLifeTime() == 0.0f);
 		testSystem.update(dt, numberOfSpawnDirections, angle);
-		REQUIRE(testSystem.getParticles[0].getLifeTime() == 0.0f);
+		// The dead particle is removed and replaced by a newly spawned one
+		REQUIRE(testSystem.getParticles().size() == 1);
+		REQUIRE(testSystem.getParticles()[0].getLifeTime() == 0.0f);
 	}
 }
 
+TEST_CASE("The particle view does not copy and a snapshot does", "ParticleSystem") {
+	ParticleSystem testSystem;
+	testSystem.addUniform({ 0.0f, 0.0f });
+	testSystem.update(0.1f, 4, 0.0f);
+
+	const ParticleView view = testSystem.getParticles();
+	REQUIRE(view.size() == 1);
+	REQUIRE(view.data() == testSystem.getParticles().data());
+	REQUIRE(view.getArchetypes()[view[0].getArchetype()].radius == 3.0f);
+
+	const std::vector<Particle> snapshot = testSystem.snapshotParticles();
+	testSystem.update(0.1f, 4, 0.0f);
+	REQUIRE(snapshot.size() == 1);
+	REQUIRE(testSystem.getParticles().size() == 2);
+	REQUIRE(snapshot[0].getLifeTime() > testSystem.getParticles()[0].getLifeTime());
+}
+
+TEST_CASE("Parallel emission places particles in emitter order", "ParticleSystem") {
+	ParticleSystem testSystem;
+	constexpr int NumberOfEmitters = 1000;
+	std::size_t expectedCount = 0;
+	for (int i = 0; i < NumberOfEmitters; i++) {
+		const vec2 position = { static_cast<float>(i), 0.0f };
+		const EmitterHandle handle = (i % 2 == 0) ? testSystem.addUniform(position)
+		                                          : testSystem.addDirectional(position);
+		testSystem.getEmitter(handle).setSpawnRate(i % 3 + 1);
+		expectedCount += i % 3 + 1;
+	}
+	testSystem.update(0.0f, 8, 0.0f);
+
+	// Uniform emitters come first, then directional ones, each in the order they were added
+	const ParticleView view = testSystem.getParticles();
+	REQUIRE(view.size() == expectedCount);
+	std::size_t index = 0;
+	for (int type = 0; type < 2; type++) {
+		for (int i = type; i < NumberOfEmitters; i += 2) {
+			for (int j = 0; j < i % 3 + 1; j++) {
+				REQUIRE(view[index].getPosition().x == static_cast<float>(i));
+				index++;
+			}
+		}
+	}
+}
+
+TEST_CASE("Chunked updates keep the particle order across compaction", "ParticleSystem") {
+	// Culling forces is computed over all particles at once, which splits the update graph
+	ParticleSystem chained;
+	ParticleSystem split;
+	split.setForceCullingEnabled(true);
+	for (ParticleSystem* system : { &chained, &split }) {
+		system->getEmitter(system->addUniform({ -0.5f, 0.0f })).setSpawnRate(10000);
+		system->getEmitter(system->addDirectional({ 0.5f, 0.0f })).setSpawnRate(10000);
+		// Each batch lives for three updates, the oldest one has died after the fourth
+		for (int i = 0; i < 4; i++) {
+			system->update(25.0f, 16, 0.0f);
+		}
+	}
+
+	const ParticleView a = chained.getParticles();
+	const ParticleView b = split.getParticles();
+	REQUIRE(a.size() == 60000);
+	REQUIRE(b.size() == a.size());
+	bool ordered = true;
+	bool identical = true;
+	for (std::size_t i = 0; i < a.size(); i++) {
+		ordered &= i == 0 || a[i - 1].getLifeTime() <= a[i].getLifeTime();
+		identical &= a[i].getLifeTime() == b[i].getLifeTime();
+		identical &= a[i].getPosition().x == b[i].getPosition().x;
+		identical &= a[i].getPosition().y == b[i].getPosition().y;
+	}
+	REQUIRE(ordered);
+	REQUIRE(identical);
+}
+
+TEST_CASE("The uniform emitter steps around the ring without trigonometry per particle", "ParticleSystem") {
+	const double TwoPi = 6.283185307179586;
+	Uniform emitter({ 0.0f, 0.0f }, 1.0f, Color(1.0f, 1.0f, 1.0f));
+	emitter.setSpawnRate(5);
+
+	// A whole number of directions comes from the table, the rest from the rotation. Each
+	// particle should leave one step after the previous one, also after a long run
+	const float counts[] = { 6.0f, 7.5f, 360.0f, 1000.5f };
+	double previousAngle = 0.0;
+	bool evenSteps = true;
+	bool constantSpeed = true;
+	for (float count : counts) {
+		for (int call = 0; call < 20000; call++) {
+			for (const Particle& p : emitter.createParticles(count, 0.0f)) {
+				const vec2 v = p.getVelocity();
+				const double angle = std::atan2(v.y, v.x);
+				const double error = std::remainder(angle - previousAngle - TwoPi / count, TwoPi);
+				evenSteps = evenSteps && std::abs(error) < 1e-5;
+				constantSpeed = constantSpeed && std::abs(v.length() - 0.3f) < 1e-5f;
+				previousAngle = angle;
+			}
+		}
+	}
+	REQUIRE(evenSteps);
+	REQUIRE(constantSpeed);
+}
+
+TEST_CASE("A directional emitter spreads its particles over the step", "ParticleSystem") {
+	const vec2 position = { 0.1f, 0.2f };
+	Directional emitter(position, 1.0f, Color(1.0f, 1.0f, 1.0f), 0.0f);
+	emitter.setSpawnRate(4);
+	emitter.setTimestep(0.01f);
+	const std::vector<Particle> particles = emitter.createParticles(6.0f, 0.0f);
+	REQUIRE(particles.size() == 4);
+
+	// Partikel k har färdats k/4 av steget men lever lika länge som de andra
+	const vec2 velocity = particles[0].getVelocity();
+	for (int k = 0; k < 4; k++) {
+		const float age = 0.01f * k / 4;
+		const vec2 expected = position + velocity * age;
+		REQUIRE(particles[k].getVelocity().x == Approx(velocity.x));
+		REQUIRE(particles[k].getPosition().x == Approx(expected.x));
+		REQUIRE(particles[k].getPosition().y == Approx(expected.y));
+		REQUIRE(particles[k].getLifeTime() == particles[0].getLifeTime());
+	}
+	REQUIRE(particles[1].getPosition().x != particles[0].getPosition().x);
+}
@@ -0,0 +1,47 @@
+#include "catch2.h"
+#include "particle.h"
+#include "particleArchetype.hpp"
+
+TEST_CASE("Identical archetypes share one table entry", "[archetype]") {
+    ParticleArchetypeTable table;
+    const std::uint32_t a = table.add({3.0f, {1, 0, 0}, 20.0f, 60.0f});
+    const std::uint32_t b = table.add({3.0f, {0, 1, 0}, 20.0f, 60.0f});
+    const std::uint32_t c = table.add({3.0f, {1, 0, 0}, 20.0f, 60.0f});
+
+    REQUIRE(a != b);
+    REQUIRE(a == c);
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.getMass(a) == Approx(0.05f));
+}
+
+TEST_CASE("Unique archetypes are never shared", "[archetype]") {
+    ParticleArchetypeTable table;
+    const ParticleArchetype red = {3.0f, {1, 0, 0}, 20.0f, 60.0f};
+    const std::uint32_t a = table.add(red);
+    const std::uint32_t b = table.addUnique(red);
+    const std::uint32_t c = table.add(red);
+
+    REQUIRE(a != b);
+    REQUIRE(a == c);
+    REQUIRE(table.isShared(a));
+    REQUIRE_FALSE(table.isShared(b));
+    REQUIRE(table.getMass(b) == Approx(0.05f));
+}
+
+TEST_CASE("Particles look up their constants in the archetype table", "[archetype]") {
+    ParticleArchetypeTable table;
+    const std::uint32_t index = table.add({4.0f, {0.5f, 0.25f, 1}, 2.0f, 10.0f});
+
+    Particle p({0.0f, 0.0f}, {0.0f, 0.0f}, index, table[index].lifetime);
+    REQUIRE(p.getLifeTime() == 10.0f);
+
+    // Force 1 on a particle with mass 0.5 gives acceleration 2
+    p.updateSingleParticle(1.0f, {1.0f, 0.0f}, table[index].inverseMass);
+    REQUIRE(p.getPosition().x == Approx(2.0f));
+    REQUIRE(p.getLifeTime() == 9.0f);
+
+    const rendering::ParticleInfo info = p.toParticleInfo(table);
+    REQUIRE(info.radius == 4.0f);
+    REQUIRE(info.color.g == 0.25f);
+    REQUIRE(sizeof(Particle) <= 24);
+}
@@ -0,0 +1,36 @@
+#include "catch2.h"
+#include "util/perfstats.h"
+
+TEST_CASE("Sample ring keeps the most recent samples", "[perf]") {
+    perf::SampleRing ring(4);
+    REQUIRE(ring.size() == 0);
+    REQUIRE(ring.percentile(50.0f) == 0.0f);
+
+    for (int i = 1; i <= 6; i++) {
+        ring.push(static_cast<float>(i));
+    }
+    REQUIRE(ring.size() == 4);
+    REQUIRE(ring.latest() == 6.0f);
+    REQUIRE(ring.mean() == Approx(4.5f));
+    // The oldest remaining sample (3) is stored at the offset
+    REQUIRE(ring.data()[ring.offset()] == 3.0f);
+}
+
+TEST_CASE("Sample ring percentiles and histogram", "[perf]") {
+    perf::SampleRing ring(100);
+    for (int i = 0; i < 100; i++) {
+        ring.push(static_cast<float>(99 - i));
+    }
+    REQUIRE(ring.percentile(0.0f) == 0.0f);
+    REQUIRE(ring.percentile(50.0f) == Approx(50.0f).margin(1.0f));
+    REQUIRE(ring.percentile(99.0f) == Approx(98.0f).margin(1.0f));
+    REQUIRE(ring.percentile(100.0f) == 99.0f);
+
+    float bins[4];
+    ring.histogram(bins, 4, 80.0f);
+    REQUIRE(bins[0] == 20.0f);
+    REQUIRE(bins[1] == 20.0f);
+    REQUIRE(bins[2] == 20.0f);
+    // Everything from 60 and up, including samples above the maximum
+    REQUIRE(bins[3] == 40.0f);
+}
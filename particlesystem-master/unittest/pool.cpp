@@ -0,0 +1,82 @@
+#include "catch2.h"
+#include "util/pool.h"
+#include "particlesystem.h"
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("Removing from a pool keeps the other keys valid", "[pool]") {
+    Pool<int> pool;
+    std::vector<Pool<int>::Key> keys;
+    for (int i = 0; i < 10; i++) {
+        keys.push_back(pool.add(i));
+    }
+
+    REQUIRE(pool.remove(keys[3]));
+    REQUIRE(pool.remove(keys[0]));
+    REQUIRE_FALSE(pool.remove(keys[3]));
+    REQUIRE(pool.size() == 8);
+    REQUIRE_FALSE(pool.contains(keys[0]));
+
+    bool stillThere = true;
+    for (int i = 0; i < 10; i++) {
+        if (i != 0 && i != 3) {
+            stillThere = stillThere && pool.contains(keys[i]) && pool[keys[i]] == i;
+        }
+    }
+    REQUIRE(stillThere);
+
+    // The storage stays dense and every key maps back to its own position
+    std::vector<int> values(pool.begin(), pool.end());
+    std::sort(values.begin(), values.end());
+    REQUIRE(values == std::vector<int>{ 1, 2, 4, 5, 6, 7, 8, 9 });
+    bool consistent = true;
+    for (std::size_t p = 0; p < pool.size(); p++) {
+        consistent = consistent && &pool[pool.keyAt(p)] == &*(pool.begin() + p);
+    }
+    REQUIRE(consistent);
+}
+
+TEST_CASE("A reused slot does not accept the old key", "[pool]") {
+    Pool<int> pool;
+    const Pool<int>::Key first = pool.add(1);
+    pool.remove(first);
+    const Pool<int>::Key second = pool.add(2);
+
+    REQUIRE(second.index == first.index);
+    REQUIRE(second.generation != first.generation);
+    REQUIRE_FALSE(pool.contains(first));
+    REQUIRE(pool[second] == 2);
+
+    // After clear the slots are handed out from 0 again, but the old keys stay invalid
+    pool.add(3);
+    pool.clear();
+    REQUIRE(pool.empty());
+    REQUIRE_FALSE(pool.contains(second));
+    REQUIRE(pool.add(4).index == 0);
+    REQUIRE(pool.add(5).index == 1);
+}
+
+TEST_CASE("Emitters and forces can be removed through their handles", "[pool]") {
+    ParticleSystem system;
+    const EmitterHandle a = system.addUniform({ -0.5f, 0.0f });
+    const EmitterHandle b = system.addUniform({ 0.5f, 0.0f });
+    const ForceHandle well = system.addGravityWell({ 0.0f, 0.0f });
+    system.getEmitter(b).setSpawnRate(3);
+
+    REQUIRE(system.removeEmitter(a));
+    REQUIRE_FALSE(system.removeEmitter(a));
+    REQUIRE_FALSE(system.isValid(a));
+    REQUIRE(system.isValid(b));
+    REQUIRE(system.getEmitter(b).getSpawnRate() == 3);
+    REQUIRE(system.getNumberOfEmitters() == 1);
+
+    // Only the remaining emitter creates particles
+    system.update(0.0f, 8, 0.0f);
+    REQUIRE(system.getParticles().size() == 3);
+
+    REQUIRE(system.removeForce(well));
+    REQUIRE(system.getNumberOfForces() == 0);
+    REQUIRE_FALSE(system.isValid(well));
+    system.update(0.01f, 8, 0.0f);
+    REQUIRE(system.getParticles().size() == 6);
+}
@@ -0,0 +1,95 @@
+#include "catch2.h"
+#include "util/random.h"
+#include "particlesystem.h"
+#include <vector>
+
+TEST_CASE("Philox matches the reference vectors", "[random]") {
+    // Known answers from the Random123 distribution
+    REQUIRE(rng::philox({ 0, 0, 0, 0 }, { 0, 0 }) ==
+            rng::Counter{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 });
+    REQUIRE(rng::philox({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }) ==
+            rng::Counter{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd });
+    REQUIRE(rng::philox({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }) ==
+            rng::Counter{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 });
+}
+
+TEST_CASE("Batches give the same values as single elements", "[random]") {
+    const rng::Stream stream(12345, 7);
+    constexpr std::size_t Count = 37;
+    // Starting close to a 32-bit boundary checks that the carry into the high word works
+    const std::uint64_t firstIndex = 0xfffffff0ull;
+    std::vector<float> values(4 * Count);
+    float* const out[4] = { values.data(), values.data() + Count, values.data() + 2 * Count,
+                            values.data() + 3 * Count };
+    stream.uniformBatch(firstIndex, Count, out);
+
+    bool identical = true;
+    bool inRange = true;
+    for (std::size_t i = 0; i < Count; i++) {
+        const std::array<float, 4> single = stream.uniform4(firstIndex + i);
+        for (int k = 0; k < 4; k++) {
+            identical &= single[k] == out[k][i];
+            inRange &= out[k][i] >= 0.0f && out[k][i] < 1.0f;
+        }
+    }
+    REQUIRE(identical);
+    REQUIRE(inRange);
+
+    // Different ids and purposes give different streams
+    REQUIRE(rng::Stream(12345, 8).uniform4(0) != stream.uniform4(0));
+    REQUIRE(rng::Stream(12345, 7, 1).uniform4(0) != stream.uniform4(0));
+}
+
+TEST_CASE("A sequence uses all four numbers of each element", "[random]") {
+    const rng::Stream stream(99, 3, 2);
+    // Starts and ends inside an element, with enough whole elements for the SSE path
+    for (std::uint64_t first : { 0ull, 1ull, 6ull, 0x3fffffffdull }) {
+        for (std::size_t count : { 0, 3, 17, 50 }) {
+            std::vector<float> values(count);
+            stream.uniformSequence(first, count, values.data());
+            bool identical = true;
+            for (std::size_t i = 0; i < count; i++) {
+                const std::uint64_t n = first + i;
+                identical &= values[i] == stream.uniform4(n / 4)[n % 4];
+            }
+            REQUIRE(identical);
+        }
+    }
+}
+
+TEST_CASE("Jittered emitters are reproducible and vary", "[random]") {
+    EmitterJitter jitter;
+    jitter.angle = 0.5f;
+    jitter.speed = 0.3f;
+    jitter.lifetime = 0.2f;
+    jitter.color = 0.2f;
+
+    std::vector<Particle> runs[2];
+    for (std::vector<Particle>& run : runs) {
+        ParticleSystem system;
+        system.setSeed(99);
+        const EmitterHandle handle = system.addDirectional({ 0.0f, 0.0f });
+        system.getEmitter(handle).setSpawnRate(100);
+        system.setEmitterJitter(handle, jitter);
+        system.update(0.0f, 4, 0.0f);
+        system.update(0.0f, 4, 0.0f);
+        run = system.snapshotParticles();
+    }
+
+    REQUIRE(runs[0].size() == 200);
+    bool identical = true;
+    bool lifetimesVary = false;
+    bool archetypesVary = false;
+    for (std::size_t i = 0; i < runs[0].size(); i++) {
+        identical &= runs[0][i].getVelocity().x == runs[1][i].getVelocity().x;
+        identical &= runs[0][i].getLifeTime() == runs[1][i].getLifeTime();
+        identical &= runs[0][i].getArchetype() == runs[1][i].getArchetype();
+        lifetimesVary |= runs[0][i].getLifeTime() != runs[0][0].getLifeTime();
+        archetypesVary |= runs[0][i].getArchetype() != runs[0][0].getArchetype();
+        REQUIRE(runs[0][i].getLifeTime() >= 60.0f * 0.8f);
+        REQUIRE(runs[0][i].getLifeTime() <= 60.0f * 1.2f);
+    }
+    REQUIRE(identical);
+    REQUIRE(lifetimesVary);
+    REQUIRE(archetypesVary);
+}
@@ -0,0 +1,81 @@
+#include "catch2.h"
+#include "util/rendering.h"
+#include <thread>
+#include <vector>
+
+using rendering::LayerQueue;
+
+namespace {
+    std::vector<rendering::ParticleInfo> particlesAt(float x, int count) {
+        rendering::ParticleInfo p;
+        p.position = { x, 0.0f };
+        return std::vector<rendering::ParticleInfo>(count, p);
+    }
+} // namespace
+
+TEST_CASE("Layers are drained in order and emptied", "[rendering]") {
+    LayerQueue queue;
+    queue.submitParticles(3, particlesAt(3.0f, 2));
+    queue.submitForces(3, std::vector<rendering::ForceInfo>(1));
+    queue.submitParticles(0, particlesAt(0.0f, 1));
+    queue.submitParticles(0, particlesAt(0.5f, 1));
+    queue.submitEmitters(7, std::vector<rendering::EmitterInfo>(4));
+
+    // Empty layers are skipped, submissions to a layer keep their order
+    std::vector<int> drained;
+    queue.drain([&](int layer, const LayerQueue::Layer& contents) {
+        drained.push_back(layer);
+        if (layer == 0) {
+            REQUIRE(contents.particles.size() == 2);
+            REQUIRE(contents.particles[0].position.x == 0.0f);
+            REQUIRE(contents.particles[1].position.x == 0.5f);
+        }
+        if (layer == 3) {
+            REQUIRE(contents.particles.size() == 2);
+            REQUIRE(contents.forces.size() == 1);
+            REQUIRE(contents.emitters.empty());
+        }
+        if (layer == 7) {
+            REQUIRE(contents.emitters.size() == 4);
+        }
+    });
+    REQUIRE(drained == std::vector<int>{ 0, 3, 7 });
+
+    // Nothing is left for the next frame
+    int calls = 0;
+    queue.drain([&](int, const LayerQueue::Layer&) { calls++; });
+    REQUIRE(calls == 0);
+
+    queue.submitEmitters(5, std::vector<rendering::EmitterInfo>(1));
+    drained.clear();
+    queue.drain([&](int layer, const LayerQueue::Layer& contents) {
+        drained.push_back(layer);
+        REQUIRE(contents.particles.empty());
+    });
+    REQUIRE(drained == std::vector<int>{ 5 });
+}
+
+TEST_CASE("Layers can be filled from several threads", "[rendering]") {
+    LayerQueue queue;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&queue, t]() {
+            for (int i = 0; i < 100; i++) {
+                queue.submitParticles(t % 2, particlesAt(static_cast<float>(t), 3));
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    std::size_t total = 0;
+    queue.drain([&](int layer, const LayerQueue::Layer& contents) {
+        REQUIRE(contents.particles.size() == 600);
+        for (const rendering::ParticleInfo& p : contents.particles) {
+            REQUIRE(static_cast<int>(p.position.x) % 2 == layer);
+        }
+        total += contents.particles.size();
+    });
+    REQUIRE(total == 1200);
+}
@@ -0,0 +1,158 @@
+#include "catch2.h"
+#include "scenario.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    Scenario parse(const char* text) {
+        std::istringstream input(text);
+        return parseScenario(input);
+    }
+} // namespace
+
+TEST_CASE("Scenario commands are parsed", "[scenario]") {
+    const Scenario s = parse(
+        "name Test scene  # with a comment\n"
+        "\n"
+        "timestep 0.01\n"
+        "duration 2\n"
+        "spawnDirections 12\n"
+        "set nBody on\n"
+        "set gravitySoftening 0.05\n"
+        "uniform 0.5 -0.5 3\n"
+        "directional 0 0\n"
+        "gravity 0.1 0.2 0.3\n"
+        "wind -0.1 0 1.5 0.25\n");
+
+    REQUIRE(s.name == "Test scene");
+    REQUIRE(s.timestep == 0.01f);
+    REQUIRE(s.duration == 2.0f);
+    REQUIRE(s.numberOfSpawnDirections == 12.0f);
+    REQUIRE(s.nBody);
+    REQUIRE_FALSE(s.forceField);
+    REQUIRE(s.gravitySoftening == 0.05f);
+
+    REQUIRE(s.emitters.size() == 2);
+    REQUIRE(s.emitters[0].type == EmitterHandle::Type::Uniform);
+    REQUIRE(s.emitters[0].position.x == 0.5f);
+    REQUIRE(s.emitters[0].rate == 3);
+    REQUIRE(s.emitters[1].rate == 1);
+
+    REQUIRE(s.forces.size() == 2);
+    REQUIRE(s.forces[0].radius == 0.3f);
+    REQUIRE(s.forces[1].type == ForceHandle::Type::Wind);
+    REQUIRE(s.forces[1].angle == 1.5f);
+    REQUIRE(s.forces[1].radius == 0.25f);
+}
+
+TEST_CASE("Generated objects are reproducible", "[scenario]") {
+    const char* text =
+        "seed 5\n"
+        "random gravity 10 0.2\n"
+        "ring uniform 8 0.5 2\n"
+        "grid wind 4 3\n";
+    const Scenario a = parse(text);
+    const Scenario b = parse(text);
+
+    REQUIRE(a.forces.size() == 10 + 12);
+    REQUIRE(a.emitters.size() == 8);
+    for (std::size_t i = 0; i < a.forces.size(); i++) {
+        REQUIRE(a.forces[i].position.x == b.forces[i].position.x);
+        REQUIRE(a.forces[i].position.y == b.forces[i].position.y);
+        REQUIRE(std::abs(a.forces[i].position.x) <= 0.9f);
+    }
+    REQUIRE(a.forces[0].radius == 0.2f);
+    REQUIRE(a.emitters[2].position.y == Approx(0.5f));
+    REQUIRE(a.emitters[2].rate == 2);
+
+    const Scenario c = parse("seed 6\nrandom gravity 10 0.2\n");
+    REQUIRE(c.forces[0].position.x != a.forces[0].position.x);
+}
+
+TEST_CASE("Malformed scenarios report the line", "[scenario]") {
+    REQUIRE_THROWS_WITH(parse("uniform 0 0\nexplode 1\n"), Catch::Contains("line 2"));
+    REQUIRE_THROWS_AS(parse("gravity 0\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse("wind 0 0 fast\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse("uniform 0 0 1 2\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse("set nBody maybe\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(getScenarioPreset("does not exist"), std::runtime_error);
+}
+
+TEST_CASE("Presets parse and set up a particle system", "[scenario]") {
+    for (const std::string& name : getScenarioPresets()) {
+        const Scenario scenario = getScenarioPreset(name);
+        REQUIRE_FALSE(scenario.name.empty());
+
+        ParticleSystem system;
+        applyScenario(scenario, system);
+        REQUIRE(system.getNumberOfEmitters() == scenario.emitters.size());
+        REQUIRE(system.getNumberOfForces() == scenario.forces.size());
+    }
+
+    const Scenario million = getScenarioPreset("million");
+    REQUIRE(million.emitters.size() == 256);
+    REQUIRE(million.forces.size() == 64);
+}
+
+TEST_CASE("The million preset reaches a million particles", "[scenario]") {
+    const Scenario million = getScenarioPreset("million");
+    const int frames = static_cast<int>(std::lround(million.duration / million.timestep));
+    REQUIRE(frames == 3600);
+    int perFrame = 0;
+    for (const Scenario::EmitterDescription& e : million.emitters) {
+        perFrame += e.rate;
+    }
+    REQUIRE(perFrame * frames == 224 * 3600 + 32 * 2 * 3600);
+
+    // Nothing dies during the run, so a few frames show the growth of the whole run
+    ParticleSystem system;
+    applyScenario(million, system);
+    for (int i = 0; i < 3; i++) {
+        system.update(million.timestep, million.numberOfSpawnDirections, million.angle);
+    }
+    const ParticleView particles = system.getParticles();
+    REQUIRE(particles.size() == static_cast<std::size_t>(3 * perFrame));
+    float shortestLifetime = particles[0].getLifeTime();
+    for (std::size_t i = 0; i < particles.size(); i++) {
+        shortestLifetime = std::min(shortestLifetime, particles[i].getLifeTime());
+    }
+    REQUIRE(shortestLifetime + 3 * million.timestep >= million.duration);
+}
+
+TEST_CASE("Jitter applies to the emitters that follow it", "[scenario]") {
+    const Scenario s = parse(
+        "uniform 0 0\n"
+        "jitter 0.1 0.2 0.3 0.4\n"
+        "ring directional 3 0.5\n");
+
+    REQUIRE(s.emitters.size() == 4);
+    REQUIRE_FALSE(s.emitters[0].jitter.isActive());
+    for (std::size_t i = 1; i < s.emitters.size(); i++) {
+        REQUIRE(s.emitters[i].jitter.angle == 0.1f);
+        REQUIRE(s.emitters[i].jitter.color == 0.4f);
+    }
+    REQUIRE_THROWS_AS(parse("jitter 0.1 0.2\n"), std::runtime_error);
+}
+
+TEST_CASE("Shape emitters are parsed", "[scenario]") {
+    const Scenario s = parse(
+        "line 0 0 1 0.5 4\n"
+        "annulus 0.2 0.2 0.1 0.3\n"
+        "polyline 2 0 0 1 0 1 1\n");
+
+    REQUIRE(s.emitters.size() == 3);
+    REQUIRE(s.emitters[0].type == EmitterHandle::Type::Shape);
+    REQUIRE(s.emitters[0].rate == 4);
+    // Lines are placed at their midpoint
+    REQUIRE(s.emitters[0].position.x == 0.5f);
+    REQUIRE(s.emitters[0].shape.points[1].y == 0.25f);
+    REQUIRE(s.emitters[1].shape.type == EmitterShape::Type::Annulus);
+    REQUIRE(s.emitters[1].shape.outerRadius == 0.3f);
+    REQUIRE(s.emitters[2].shape.points.size() == 3);
+
+    REQUIRE_THROWS_AS(parse("annulus 0 0 0.3 0.1\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse("disc 0 0 0\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse("polyline 2 0 0 1\n"), std::runtime_error);
+}
@@ -0,0 +1,88 @@
+#include "catch2.h"
+#include "shapeEmitter.hpp"
+#include <cmath>
+#include <vector>
+
+namespace {
+    std::vector<Particle> sample(const EmitterShape& shape, int count, vec2 position = { 0.0f, 0.0f }) {
+        ShapeEmitter emitter(position, 8.0f, { 1.0f, 1.0f, 1.0f }, shape);
+        emitter.setSpawnRate(count);
+        return emitter.createParticles(8.0f, 0.0f);
+    }
+} // namespace
+
+TEST_CASE("Shape emitters spawn inside their shape", "[shapeemitter]") {
+    const vec2 centre = { 0.3f, -0.2f };
+
+    bool inside = true;
+    for (const Particle& p : sample(EmitterShape::disc(0.25f), 1000, centre)) {
+        inside = inside && (p.getPosition() - centre).length() <= 0.25f * 1.0001f;
+    }
+    for (const Particle& p : sample(EmitterShape::rectangle({ 0.4f, 0.1f }), 1000, centre)) {
+        const vec2 local = p.getPosition() - centre;
+        inside = inside && std::abs(local.x) <= 0.4f && std::abs(local.y) <= 0.1f;
+    }
+    for (const Particle& p : sample(EmitterShape::line({ -0.5f, 0.0f }, { 0.5f, 0.0f }), 1000, centre)) {
+        const vec2 local = p.getPosition() - centre;
+        inside = inside && std::abs(local.x) <= 0.5f && std::abs(local.y) < 1e-6f;
+        // Lines emit along their left normal
+        inside = inside && std::abs(p.getVelocity().x) < 1e-6f && p.getVelocity().y > 0.0f;
+    }
+    REQUIRE(inside);
+}
+
+TEST_CASE("Annulus radii are uniform over the area", "[shapeemitter]") {
+    const float inner = 0.1f;
+    const float outer = 0.3f;
+    const std::vector<Particle> particles = sample(EmitterShape::annulus(inner, outer), 20000);
+
+    // The area inside the middle radius is half of the annulus
+    const float middle = std::sqrt(0.5f * (inner * inner + outer * outer));
+    int insideMiddle = 0;
+    bool inRange = true;
+    for (const Particle& p : particles) {
+        const float r = p.getPosition().length();
+        inRange = inRange && r >= inner * 0.9999f && r <= outer * 1.0001f;
+        insideMiddle += r < middle;
+    }
+    REQUIRE(inRange);
+    REQUIRE(std::abs(insideMiddle / 20000.0f - 0.5f) < 0.02f);
+}
+
+TEST_CASE("Polylines are sampled in proportion to segment length", "[shapeemitter]") {
+    // Three segments of length 1, 2 and 5 along the x axis
+    const EmitterShape shape = EmitterShape::polyline({ { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 3.0f, 0.0f }, { 8.0f, 0.0f } });
+    const std::vector<Particle> particles = sample(shape, 40000);
+
+    int counts[3] = { 0, 0, 0 };
+    for (const Particle& p : particles) {
+        const float x = p.getPosition().x;
+        counts[x < 1.0f ? 0 : x < 3.0f ? 1 : 2]++;
+    }
+    REQUIRE(std::abs(counts[0] / 40000.0f - 1.0f / 8) < 0.01f);
+    REQUIRE(std::abs(counts[1] / 40000.0f - 2.0f / 8) < 0.01f);
+    REQUIRE(std::abs(counts[2] / 40000.0f - 5.0f / 8) < 0.01f);
+}
+
+TEST_CASE("Shape emitters repeat with the same stream", "[shapeemitter]") {
+    const EmitterShape shape = EmitterShape::polyline({ { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 2.0f, 0.0f } });
+    ShapeEmitter a({ 0.0f, 0.0f }, 8.0f, { 1.0f, 1.0f, 1.0f }, shape);
+    ShapeEmitter b({ 0.0f, 0.0f }, 8.0f, { 1.0f, 1.0f, 1.0f }, shape);
+    a.setStream(rng::Stream(7, 2, 3));
+    b.setStream(rng::Stream(7, 2, 3));
+    a.setSpawnRate(10);
+    b.setSpawnRate(5);
+
+    // The same particles whether they are created ten at a time or five at a time
+    std::vector<Particle> first = a.createParticles(8.0f, 0.0f);
+    std::vector<Particle> second = b.createParticles(8.0f, 0.0f);
+    const std::vector<Particle> rest = b.createParticles(8.0f, 0.0f);
+    second.insert(second.end(), rest.begin(), rest.end());
+
+    bool same = first.size() == second.size();
+    for (std::size_t i = 0; same && i < first.size(); i++) {
+        same = first[i].getPosition().x == second[i].getPosition().x &&
+               first[i].getPosition().y == second[i].getPosition().y;
+    }
+    REQUIRE(same);
+}
@@ -0,0 +1,151 @@
+#include "catch2.h"
+#include "particlesystem.h"
+#include "subEmitter.hpp"
+#include <cmath>
+#include <vector>
+
+namespace {
+    // Kills the particles of a directional emitter at (0, 0) in two updates, the next
+    // update turns them into bursts
+    void spawnAndKill(ParticleSystem& system) {
+        system.update(0.0f, 8, 0.0f);
+        system.update(61.0f, 8, 0.0f);
+    }
+} // namespace
+
+TEST_CASE("Dying particles burst where they die", "[subemitter]") {
+    ParticleSystem system;
+    const EmitterHandle handle = system.addDirectional({ 0.0f, 0.0f });
+    SubEmitterDescription burst;
+    burst.count = 8;
+    burst.speed = 0.5f;
+    burst.inheritVelocity = 0.25f;
+    REQUIRE(system.addSubEmitters(handle, { burst }) == 1);
+
+    spawnAndKill(system);
+    REQUIRE(system.getParticles().size() == 2);
+    system.update(0.0f, 8, 0.0f);
+
+    // One new particle from the emitter, then the two bursts in the order the particles died
+    const ParticleView view = system.getParticles();
+    REQUIRE(view.size() == 1 + 2 * 8);
+    bool atDeath = true;
+    bool velocities = true;
+    for (std::size_t i = 1; i < view.size(); i++) {
+        const Particle& p = view[i];
+        atDeath = atDeath && p.getPosition().x == 610.0f && p.getPosition().y == 0.0f;
+        const float angle = 2.0f * 3.141592654f * ((i - 1) % 8) / 8;
+        const vec2 expected = vec2(10.0f, 0.0f) * 0.25f + vec2(std::cos(angle), std::sin(angle)) * 0.5f;
+        velocities = velocities && (p.getVelocity() - expected).length() < 1e-5f;
+        velocities = velocities && p.getLifeTime() == burst.archetype.lifetime;
+    }
+    REQUIRE(atDeath);
+    REQUIRE(velocities);
+}
+
+TEST_CASE("Only the emitter that got sub-emitters bursts", "[subemitter]") {
+    // Three emitters with identical particles, the sub-emitters go to the middle one. The
+    // last one is added afterwards and must not pick up its archetype either
+    ParticleSystem system;
+    system.addDirectional({ 0.0f, 0.0f });
+    const EmitterHandle handle = system.addDirectional({ 0.0f, 0.0f });
+    SubEmitterDescription burst;
+    burst.count = 8;
+    REQUIRE(system.addSubEmitters(handle, { burst }) == 1);
+    system.addDirectional({ 0.0f, 0.0f });
+
+    spawnAndKill(system);
+    REQUIRE(system.getParticles().size() == 3 * 2);
+    system.update(0.0f, 8, 0.0f);
+    REQUIRE(system.getParticles().size() == 3 + 2 * 8);
+}
+
+TEST_CASE("Sub-emitters chain and refuse to trigger themselves", "[subemitter]") {
+    ParticleSystem system;
+    const EmitterHandle handle = system.addDirectional({ 0.0f, 0.0f });
+    SubEmitterDescription first;
+    first.count = 4;
+    SubEmitterDescription second = first;
+    second.count = 3;
+    second.archetype.color = { 0.0f, 0.0f, 1.0f };
+    // The third stage creates the same archetype as the first, so it would loop forever
+    REQUIRE(system.addSubEmitters(handle, { first, second, first }) == 2);
+
+    spawnAndKill(system);
+    system.update(0.0f, 8, 0.0f);
+    REQUIRE(system.getParticles().size() == 1 + 2 * 4);
+
+    // The first bursts live for a second, when they die they burst into the second stage.
+    // Meanwhile the emitter has added two more particles
+    system.update(2.0f, 8, 0.0f);
+    system.update(0.0f, 8, 0.0f);
+    REQUIRE(system.getParticles().size() == 3 + 2 * 4 * 3);
+}
+
+TEST_CASE("Burst randomness does not depend on the batches", "[subemitter]") {
+    SubEmitterDescription description;
+    description.count = 5;
+    description.speedJitter = 0.5f;
+    const SubEmitter subEmitter(description, 0, rng::Stream(3, 1, 2));
+
+    std::vector<DeathEvent> events;
+    for (int i = 0; i < 11; i++) {
+        events.push_back({ vec2(0.1f * i, 0.0f), vec2(0.0f, 1.0f), 0 });
+    }
+    const Particle blank({ 0.0f, 0.0f }, { 0.0f, 0.0f }, 0, 0.0f);
+    std::vector<Particle> whole(events.size() * 5, blank);
+    std::vector<Particle> split(events.size() * 5, blank);
+    std::vector<float> scratch;
+    subEmitter.spawn(events.data(), events.size(), 100, whole.data(), scratch);
+    subEmitter.spawn(events.data(), 4, 100, split.data(), scratch);
+    subEmitter.spawn(events.data() + 4, 7, 100 + 4 * 5, split.data() + 4 * 5, scratch);
+
+    bool identical = true;
+    bool jittered = false;
+    for (std::size_t i = 0; i < whole.size(); i++) {
+        identical = identical && whole[i].getVelocity().x == split[i].getVelocity().x &&
+                    whole[i].getVelocity().y == split[i].getVelocity().y;
+        jittered = jittered || std::abs((whole[i].getVelocity() - vec2(0.0f, 0.5f)).length() - 0.2f) > 1e-3f;
+    }
+    REQUIRE(identical);
+    REQUIRE(jittered);
+}
+
+TEST_CASE("Removed firework emitters give back their archetypes", "[subemitter]") {
+    ParticleSystem system;
+    system.addUniform({ 0.5f, 0.0f });
+    SubEmitterDescription first;
+    first.count = 2;
+    SubEmitterDescription second = first;
+    second.archetype.color = { 0.0f, 0.0f, 1.0f };
+    EmitterJitter jitter;
+    jitter.color = 0.2f;
+
+    // The particles of the first emitter are left alive, so the table only stays flat if
+    // the removed emitters are reclaimed
+    std::size_t archetypes = 0;
+    std::size_t subEmitters = 0;
+    for (int i = 0; i < 20; i++) {
+        const EmitterHandle handle = system.addDirectional({ 0.0f, 0.0f });
+        system.setEmitterJitter(handle, jitter);
+        REQUIRE(system.addSubEmitters(handle, { first, second }) == 2);
+        system.setEmitterJitter(handle, jitter);
+        // Particles that are still alive keep the archetypes of a removed emitter
+        if (i == 0) {
+            spawnAndKill(system);
+            system.update(0.0f, 8, 0.0f);
+        }
+        REQUIRE(system.removeEmitter(handle));
+        if (i == 1) {
+            archetypes = system.getNumberOfArchetypes();
+            subEmitters = system.getNumberOfSubEmitters();
+        }
+        if (i == 2) {
+            // The bursts of the first emitter die, after that its archetypes are free
+            system.update(2.0f, 8, 0.0f);
+            system.update(2.0f, 8, 0.0f);
+        }
+    }
+    REQUIRE(system.getNumberOfArchetypes() == archetypes);
+    REQUIRE(system.getNumberOfSubEmitters() == subEmitters);
+}
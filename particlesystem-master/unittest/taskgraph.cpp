@@ -0,0 +1,81 @@
+#include "catch2.h"
+#include "util/taskgraph.h"
+#include "util/threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+TEST_CASE("Tasks run once and after their dependencies", "[taskgraph]") {
+    ThreadPool pool(4);
+    TaskGraph graph;
+
+    // A chain of three stages for each of 64 chunks, with a final task that waits for all
+    constexpr int NumberOfChunks = 64;
+    std::vector<int> stage(NumberOfChunks, 0);
+    std::atomic<int> violations = 0;
+    std::atomic<int> finishedChains = 0;
+    std::vector<TaskGraph::TaskId> lastStages;
+    for (int c = 0; c < NumberOfChunks; c++) {
+        const TaskGraph::TaskId a = graph.add("a", [&, c]() { violations += stage[c] != 0; stage[c] = 1; });
+        const TaskGraph::TaskId b = graph.add("b", [&, c]() { violations += stage[c] != 1; stage[c] = 2; }, {a});
+        lastStages.push_back(graph.add("c", [&, c]() {
+            violations += stage[c] != 2;
+            stage[c] = 3;
+            finishedChains++;
+        }, {b}));
+    }
+    int chainsSeenByLastTask = -1;
+    const TaskGraph::TaskId last = graph.add("last", [&]() { chainsSeenByLastTask = finishedChains; });
+    for (TaskGraph::TaskId id : lastStages) {
+        graph.addDependency(id, last);
+    }
+    REQUIRE(graph.size() == 3 * NumberOfChunks + 1);
+
+    graph.execute(pool);
+    REQUIRE(violations == 0);
+    REQUIRE(chainsSeenByLastTask == NumberOfChunks);
+    for (int s : stage) {
+        REQUIRE(s == 3);
+    }
+
+    // The same graph can be executed again
+    std::fill(stage.begin(), stage.end(), 0);
+    finishedChains = 0;
+    graph.execute(pool);
+    REQUIRE(violations == 0);
+    REQUIRE(chainsSeenByLastTask == NumberOfChunks);
+}
+
+TEST_CASE("A graph executed from inside a pool job runs on the calling thread", "[taskgraph]") {
+    ThreadPool pool(4);
+    std::atomic<int> counter = 0;
+    pool.run([&](unsigned threadIndex) {
+        if (threadIndex != 0) {
+            return;
+        }
+        TaskGraph graph;
+        const TaskGraph::TaskId first = graph.add("first", [&]() { counter++; });
+        graph.add("second", [&]() { counter += 10; }, {first});
+        graph.execute(pool);
+    });
+    REQUIRE(counter == 11);
+}
+
+TEST_CASE("Preferred threads never keep a task from running", "[taskgraph]") {
+    // Preferences for every thread, including ones the pool does not have
+    for (unsigned threads : { 1u, 3u }) {
+        ThreadPool pool(threads);
+        TaskGraph graph;
+        std::vector<int> stage(32, 0);
+        std::atomic<int> violations = 0;
+        for (int c = 0; c < 32; c++) {
+            const TaskGraph::TaskId a = graph.add("a", [&, c]() { violations += stage[c] != 0; stage[c] = 1; });
+            const TaskGraph::TaskId b = graph.add("b", [&, c]() { violations += stage[c] != 1; stage[c] = 2; }, {a});
+            graph.setPreferredThread(a, c);
+            graph.setPreferredThread(b, c % 2 ? TaskGraph::AnyThread : c + 1);
+        }
+        graph.execute(pool);
+        REQUIRE(violations == 0);
+        REQUIRE(std::count(stage.begin(), stage.end(), 2) == 32);
+    }
+}
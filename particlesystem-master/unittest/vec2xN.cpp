@@ -0,0 +1,117 @@
+#include "catch2.h"
+#include "util/vec2xN.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Written once and run for every width, whichever backend the compiler picked
+template <int N>
+bool operatorsMatchVec2() {
+    std::vector<vec2> a(N), b(N), out(N);
+    for (int i = 0; i < N; i++) {
+        a[i] = vec2(0.5f * i - 3.0f, 1.0f + 0.25f * i);
+        b[i] = vec2(2.0f - i, 0.75f * i + 0.5f);
+    }
+    const simd::vec2xN<N> va = simd::vec2xN<N>::load(a.data());
+    const simd::vec2xN<N> vb = simd::vec2xN<N>::load(b.data());
+
+    bool same = true;
+    const auto check = [&](const simd::vec2xN<N>& v, auto expected) {
+        v.store(out.data());
+        for (int i = 0; i < N; i++) {
+            const vec2 e = expected(i);
+            same &= std::abs(out[i].x - e.x) <= 1e-6f * (1.0f + std::abs(e.x));
+            same &= std::abs(out[i].y - e.y) <= 1e-6f * (1.0f + std::abs(e.y));
+            same &= std::abs(v[i].x - e.x) <= 1e-6f * (1.0f + std::abs(e.x));
+        }
+    };
+    check(va + vb, [&](int i) { return a[i] + b[i]; });
+    check(va - vb, [&](int i) { return a[i] - b[i]; });
+    check(va * vb, [&](int i) { return vec2(a[i].x * b[i].x, a[i].y * b[i].y); });
+    check(va * 3.0f, [&](int i) { return a[i] * 3.0f; });
+    check(va / vb.y, [&](int i) { return a[i] / b[i].y; });
+    check(va.normalized(), [&](int i) { return a[i].normalized(); });
+
+    const simd::floatxN<N> lengths = va.length();
+    const simd::floatxN<N> dots = simd::dot(va, vb);
+    for (int i = 0; i < N; i++) {
+        same &= std::abs(lengths[i] - a[i].length()) <= 1e-6f * a[i].length();
+        same &= std::abs(dots[i] - (a[i].x * b[i].x + a[i].y * b[i].y)) <= 1e-5f;
+    }
+    return same;
+}
+
+template <int N>
+bool fastVariantsAreClose() {
+    std::vector<float> values(N);
+    for (int i = 0; i < N; i++) {
+        values[i] = 1e-3f * std::pow(10.0f, static_cast<float>(i % 7));
+    }
+    const simd::floatxN<N> r = simd::rsqrtFast(simd::floatxN<N>::load(values.data()));
+    bool close = true;
+    for (int i = 0; i < N; i++) {
+        const float exact = 1.0f / std::sqrt(values[i]);
+        close &= std::abs(r[i] - exact) <= 1e-5f * exact;
+    }
+    return close;
+}
+
+template <int N>
+bool selectFollowsTheMask() {
+    std::vector<float> values(N);
+    for (int i = 0; i < N; i++) {
+        values[i] = static_cast<float>(i);
+    }
+    const simd::floatxN<N> v = simd::floatxN<N>::load(values.data());
+    const auto mask = (v >= simd::floatxN<N>(2.0f)) & (v < simd::floatxN<N>(5.0f));
+    const simd::floatxN<N> picked = simd::select(mask, v, simd::floatxN<N>(-1.0f));
+
+    bool correct = simd::any(mask) && !simd::any(v < simd::floatxN<N>(0.0f));
+    for (int i = 0; i < N; i++) {
+        correct &= picked[i] == (i >= 2 && i < 5 ? static_cast<float>(i) : -1.0f);
+    }
+    return correct;
+}
+
+template <int N>
+bool addToOnlyTouchesItsLanes() {
+    std::vector<vec2> column(N + 1, vec2(1.0f, 2.0f));
+    const simd::vec2xN<N> v(simd::floatxN<N>(0.5f), simd::floatxN<N>(-1.0f));
+    v.addTo(column.data());
+
+    bool correct = column[N].x == 1.0f && column[N].y == 2.0f;
+    for (int i = 0; i < N; i++) {
+        correct &= column[i].x == 1.5f && column[i].y == 1.0f;
+    }
+    return correct;
+}
+
+} // namespace
+
+TEST_CASE("Batch operators match vec2 for every width", "[vec2xN]") {
+    REQUIRE(operatorsMatchVec2<4>());
+    REQUIRE(operatorsMatchVec2<8>());
+    REQUIRE(operatorsMatchVec2<16>());
+    // Not a hardware width, exercises the portable fallback
+    REQUIRE(operatorsMatchVec2<3>());
+}
+
+TEST_CASE("Approximate reciprocal square root is within tolerance", "[vec2xN]") {
+    REQUIRE(fastVariantsAreClose<4>());
+    REQUIRE(fastVariantsAreClose<8>());
+    REQUIRE(fastVariantsAreClose<16>());
+}
+
+TEST_CASE("Select and masks pick the expected lanes", "[vec2xN]") {
+    REQUIRE(selectFollowsTheMask<4>());
+    REQUIRE(selectFollowsTheMask<8>());
+    REQUIRE(selectFollowsTheMask<16>());
+}
+
+TEST_CASE("Interleaved stores write exactly one batch", "[vec2xN]") {
+    REQUIRE(addToOnlyTouchesItsLanes<4>());
+    REQUIRE(addToOnlyTouchesItsLanes<8>());
+    REQUIRE(addToOnlyTouchesItsLanes<16>());
+    REQUIRE(simd::vec2v::Width == simd::NativeWidth);
+}